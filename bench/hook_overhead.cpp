@@ -0,0 +1,336 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file hook_overhead.cpp
+ * @brief Measures the cost of the hooking techniques available for the FOV accessor.
+ *
+ * @details
+ * Standalone benchmark, not part of the mod. The camera's FOV accessor is reproduced from
+ * the bytes `fovFix` matches on and called through a function pointer in four variants:
+ * unhooked, mid-hooked at the same offset as `fovFix`, inline-hooked with a C++ detour, and
+ * overwritten with an emitted stub that loads the constant and returns. For each it prints
+ * the wall time and, where the OS exposes them, the cycles and instructions retired per
+ * call with the resulting IPC, and L1 data cache, last level cache and branch misses per
+ * thousand calls, which tell a memory bound variant from a branch bound one. Hardware
+ * counters use perf_event_open on Linux; on Windows user mode has no access to them, so
+ * only time is reported there.
+ *
+ * Usage: hook_benchmark [calls], 200 million calls per variant by default.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "safetyhook.hpp"
+
+typedef float (*accessor_t)(void* camera);
+
+// Hardware events counted per variant, cycles and instructions first
+enum counter_t {
+    Cycles,
+    Instructions,
+    L1Misses,
+    LlcMisses,
+    BranchMisses,
+    CounterCount
+};
+
+typedef struct result_t {
+    double ns;
+    // Per call, negative if the event could not be counted
+    double counts[CounterCount];
+} result_t;
+
+// Offset of the FOV in the camera object, as read by the accessor
+const size_t fovOffset = 0x39C;
+// Offset of the instruction `fovFix` hooks, the `xorps` after the load
+const size_t hookOffset = 8;
+
+volatile float fovCache = 81.2f;
+
+/**
+ * @brief Allocates memory that is readable, writable and executable.
+ *
+ * @param size Bytes to allocate.
+ * @return uint8_t* The memory, nullptr on failure.
+ */
+uint8_t* allocateCode(size_t size) {
+#ifdef _WIN32
+    return (uint8_t*)VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    void* code = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return code == MAP_FAILED ? nullptr : (uint8_t*)code;
+#endif
+}
+
+/**
+ * @brief Emits a copy of the game's FOV accessor.
+ *
+ * @details
+ * The accessor loads the FOV from the camera and compares it against zero, which are the
+ * first 14 bytes `fovFix` matches on, followed by a `ret`. The camera pointer is the first
+ * argument, which is `rcx` on Windows and `rdi` everywhere else.
+ *
+ * @return accessor_t The accessor, nullptr on failure.
+ */
+accessor_t emitAccessor() {
+    uint8_t bytes[] = {
+        0xF3, 0x0F, 0x10, 0x81, 0x9C, 0x03, 0x00, 0x00,     // movss xmm0, [rcx + 0x39C]
+        0x0F, 0x57, 0xC9,                                   // xorps xmm1, xmm1
+        0x0F, 0x2F, 0xC1,                                   // comiss xmm0, xmm1
+        0xC3                                                // ret
+    };
+#ifndef _WIN32
+    bytes[3] = 0x87;                                        // movss xmm0, [rdi + 0x39C]
+#endif
+    uint8_t* code = allocateCode(0x1000);
+    if (code) {
+        memcpy(code, bytes, sizeof(bytes));
+    }
+    return (accessor_t)code;
+}
+
+/**
+ * @brief Overwrites an accessor with a stub that returns `fovCache` without touching the camera.
+ *
+ * @details
+ * `movss xmm0, [rip + 1]` followed by `ret` and the constant itself, 13 bytes, which fits
+ * in the 15 bytes of the accessor. This is the cheapest possible replacement, but the value
+ * is baked into the code, so changing it means rewriting the stub.
+ *
+ * @param accessor Accessor to overwrite.
+ * @return void
+ */
+void emitConstantStub(accessor_t accessor) {
+    auto code = (uint8_t*)accessor;
+    uint8_t bytes[] = {
+        0xF3, 0x0F, 0x10, 0x05, 0x01, 0x00, 0x00, 0x00,     // movss xmm0, [rip + 1]
+        0xC3                                                // ret
+    };
+    float value = fovCache;
+    memcpy(code, bytes, sizeof(bytes));
+    memcpy(code + sizeof(bytes), &value, sizeof(value));
+}
+
+/**
+ * @brief Hardware counters of the calling thread, where the OS exposes them.
+ */
+class Counters {
+public:
+    Counters() {
+#ifndef _WIN32
+        const uint64_t l1ReadMiss = PERF_COUNT_HW_CACHE_L1D |
+            PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+        fds[Cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[Instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[L1Misses] = open(PERF_TYPE_HW_CACHE, l1ReadMiss);
+        fds[LlcMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[BranchMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+    }
+
+    ~Counters() {
+#ifndef _WIN32
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    // Cycles and instructions are needed for anything to be reported, the rest is optional
+    bool available() const { return fds[Cycles] >= 0 && fds[Instructions] >= 0; }
+
+    bool available(counter_t counter) const { return available() && fds[counter] >= 0; }
+
+    void start() {
+#ifndef _WIN32
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop(uint64_t (&counts)[CounterCount]) {
+        for (auto& count : counts) {
+            count = 0;
+        }
+#ifndef _WIN32
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (int counter = 0; counter < CounterCount; counter++) {
+            int fd = fds[counter];
+            if (fd >= 0 && read(fd, &counts[counter], sizeof(counts[counter])) != sizeof(counts[counter])) {
+                counts[counter] = 0;
+            }
+        }
+#endif
+    }
+
+private:
+#ifndef _WIN32
+    static int open(uint32_t type, uint64_t config) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+
+    int fds[CounterCount] = { -1, -1, -1, -1, -1 };
+};
+
+/**
+ * @brief Calls `accessor` `calls` times and measures the cost per call.
+ *
+ * @param accessor Function to call.
+ * @param camera Camera object to pass.
+ * @param calls Number of calls.
+ * @param counters Hardware counters.
+ * @return result_t Cost per call.
+ */
+result_t measure(accessor_t accessor, void* camera, uint64_t calls, Counters& counters) {
+    // Through a volatile pointer, so the compiler can not see what is being called
+    accessor_t volatile call = accessor;
+    float sum = 0.0f;
+    for (uint64_t i = 0; i < calls / 100; i++) {
+        sum += call(camera);
+    }
+
+    uint64_t counts[CounterCount];
+    auto start = std::chrono::steady_clock::now();
+    counters.start();
+    for (uint64_t i = 0; i < calls; i++) {
+        sum += call(camera);
+    }
+    counters.stop(counts);
+    auto end = std::chrono::steady_clock::now();
+
+    volatile float sink = sum;
+    (void)sink;
+    result_t result;
+    result.ns = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+    for (int counter = 0; counter < CounterCount; counter++) {
+        result.counts[counter] = counters.available((counter_t)counter) ? (double)counts[counter] / calls : -1.0;
+    }
+    return result;
+}
+
+/**
+ * @brief Prints the cost per call of one variant, and relative to the unhooked accessor.
+ */
+void report(const char* name, const result_t& result, const result_t& baseline, bool counters) {
+    if (!counters) {
+        printf("%-24s %8.2f ns/call %+8.2f ns\n", name, result.ns, result.ns - baseline.ns);
+        return;
+    }
+    // Misses are rare per call, so they are shown per thousand calls
+    auto perThousand = [](double count) {
+        return count < 0.0 ? std::string("     n/a") : std::to_string(count * 1000.0).substr(0, 8);
+    };
+    printf("%-24s %8.2f ns/call %+8.2f ns %8.1f cycles/call %8.1f instructions/call %5.2f IPC "
+        "%s L1D misses %s LLC misses %s branch misses /1k calls\n",
+        name, result.ns, result.ns - baseline.ns,
+        result.counts[Cycles], result.counts[Instructions], result.counts[Instructions] / result.counts[Cycles],
+        perThousand(result.counts[L1Misses]).c_str(), perThousand(result.counts[LlcMisses]).c_str(),
+        perThousand(result.counts[BranchMisses]).c_str()
+    );
+}
+
+int main(int argc, char** argv) {
+    uint64_t calls = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000000;
+    if (calls == 0) {
+        fprintf(stderr, "usage: %s [calls]\n", argv[0]);
+        return 1;
+    }
+
+    alignas(16) static uint8_t camera[0x400]{};
+    float fov = 68.0f;
+    memcpy(camera + fovOffset, &fov, sizeof(fov));
+
+    // Every variant gets its own copy, so hooks never overlap
+    accessor_t unhooked = emitAccessor();
+    accessor_t midHooked = emitAccessor();
+    accessor_t inlineHooked = emitAccessor();
+    accessor_t stubbed = emitAccessor();
+    if (!unhooked || !midHooked || !inlineHooked || !stubbed) {
+        fprintf(stderr, "Failed to allocate executable memory\n");
+        return 1;
+    }
+
+    // Same hook body as fovFix
+    SafetyHookMid midHook = safetyhook::create_mid((uint8_t*)midHooked + hookOffset,
+        [](SafetyHookContext& ctx) {
+            ctx.xmm0.f32[0] = fovCache;
+        }
+    );
+    static SafetyHookInline inlineHook{};
+    inlineHook = safetyhook::create_inline((void*)inlineHooked,
+        +[](void*) -> float {
+            return fovCache;
+        }
+    );
+    if (!midHook || !inlineHook) {
+        fprintf(stderr, "Failed to create hooks\n");
+        return 1;
+    }
+    emitConstantStub(stubbed);
+
+    Counters counters;
+    printf("%llu calls per variant%s\n", (unsigned long long)calls,
+        counters.available() ? "" : ", hardware counters unavailable"
+    );
+    result_t baseline = measure(unhooked, camera, calls, counters);
+    report("unhooked", baseline, baseline, counters.available());
+    report("mid hook", measure(midHooked, camera, calls, counters), baseline, counters.available());
+    report("inline hook", measure(inlineHooked, camera, calls, counters), baseline, counters.available());
+    report("constant-load stub", measure(stubbed, camera, calls, counters), baseline, counters.available());
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file benchmark.hpp
+ * @brief Sequencing of a benchmark run.
+ *
+ * @details
+ * Unit tested on any platform, see tests/benchmark_test.cpp. The sequencer only sees the
+ * time of each frame and a few flags, and tells the caller what to do, so the same frames
+ * always give the same run. Recording samples, logging and reporting stay in main.cpp.
+ */
+
+#pragma once
+
+#include <chrono>
+
+namespace Utils
+{
+    /**
+     * @brief Where a benchmark run is
+     */
+    enum class benchmark_state_t {
+        Waiting,
+        Warmup,
+        Recording,
+        Done
+    };
+
+    /**
+     * @brief What the caller has to do after a frame
+     */
+    enum class benchmark_action_t {
+        None,
+        // The run was started, by the trigger or automatically
+        Started,
+        // The warmup is over, totals gathered so far have to be reset
+        ResetRegions,
+        // The totals were reset and recording started
+        Recording,
+        // The run is over and can be reported
+        Finished
+    };
+
+    /**
+     * @brief Timing of a benchmark run, in seconds
+     */
+    typedef struct benchmark_config_t {
+        // After the game is ready, 0 to only start on the trigger
+        int start = 0;
+        int delay = 10;
+        int duration = 60;
+    } benchmark_config_t;
+
+    /**
+     * @brief Steps a benchmark run through its states one frame at a time
+     * @details The run starts on the trigger, or on its own `start` seconds after the
+     *      game first reported ready. It then lets the game settle for `delay` seconds,
+     *      asks for the totals gathered so far to be reset and, once they were, records
+     *      every frame for `duration` seconds. A sequencer runs once.
+     */
+    class BenchmarkSequencer {
+    public:
+        /**
+         * @brief Outcome of a frame
+         */
+        typedef struct step_t {
+            benchmark_action_t action;
+            // Whether the frame belongs to the recording
+            bool record;
+        } step_t;
+
+        explicit BenchmarkSequencer(const benchmark_config_t& config) : config(config) {}
+
+        /**
+         * @brief Advances the run by one frame
+         *
+         * @param now Time the frame ended
+         * @param ready Whether the game is ready to be measured
+         * @param triggered Whether the run was started by hand
+         * @param regionsReset Whether the totals were reset since `ResetRegions`
+         * @return step_t
+         */
+        step_t step(std::chrono::steady_clock::time_point now, bool ready, bool triggered, bool regionsReset) {
+            switch (state) {
+                case benchmark_state_t::Waiting:
+                    if (ready && readyAt == std::chrono::steady_clock::time_point{}) {
+                        readyAt = now;
+                    }
+                    automatic = !triggered && config.start > 0 && readyAt != std::chrono::steady_clock::time_point{} &&
+                        now - readyAt >= std::chrono::seconds(config.start);
+                    if (triggered || automatic) {
+                        state = benchmark_state_t::Warmup;
+                        stateStart = now;
+                        return { benchmark_action_t::Started, false };
+                    }
+                    break;
+                case benchmark_state_t::Warmup:
+                    if (now - stateStart < std::chrono::seconds(config.delay)) {
+                        break;
+                    }
+                    if (!resetRequested) {
+                        resetRequested = true;
+                        return { benchmark_action_t::ResetRegions, false };
+                    }
+                    if (regionsReset) {
+                        state = benchmark_state_t::Recording;
+                        stateStart = now;
+                        return { benchmark_action_t::Recording, false };
+                    }
+                    break;
+                case benchmark_state_t::Recording:
+                    if (now - stateStart >= std::chrono::seconds(config.duration)) {
+                        state = benchmark_state_t::Done;
+                        return { benchmark_action_t::Finished, true };
+                    }
+                    return { benchmark_action_t::None, true };
+                case benchmark_state_t::Done:
+                    break;
+            }
+            return { benchmark_action_t::None, false };
+        }
+
+        /**
+         * @brief Current state of the run
+         *
+         * @return benchmark_state_t
+         */
+        benchmark_state_t current() const { return state; }
+
+        /**
+         * @brief Whether the run started on its own rather than on the trigger
+         *
+         * @return bool
+         */
+        bool startedAutomatically() const { return automatic; }
+
+    private:
+        benchmark_config_t config;
+        benchmark_state_t state = benchmark_state_t::Waiting;
+        std::chrono::steady_clock::time_point readyAt{};
+        std::chrono::steady_clock::time_point stateStart{};
+        bool resetRequested = false;
+        bool automatic = false;
+    };
+}
@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file frame_cap.hpp
+ * @brief Decisions of the background and idle frame cap.
+ *
+ * @details
+ * Unit tested on any platform, see tests/frame_cap_test.cpp. Everything here works on
+ * what the caller observed, the window's state and how long ago input arrived, so the
+ * Win32 calls that gather it stay in main.cpp.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace Utils
+{
+    /**
+     * @brief What the player is doing with the game window
+     */
+    enum class window_state_t {
+        Foreground,
+        Idle,
+        Background,
+        Minimized
+    };
+
+    /**
+     * @brief Classifies the game window from what is known about it
+     * @details A minimized window wins over a background one, which wins over idling. The
+     *      window counts as idle while it is in the foreground but no input arrived for
+     *      `idleAfterMs`; 0 turns idling off.
+     *
+     * @param minimized Whether the window is minimized
+     * @param foreground Whether the window is the foreground window
+     * @param sinceInputMs Milliseconds since the last keyboard, mouse or gamepad input
+     * @param idleAfterMs Milliseconds without input after which the game is idle, 0 for never
+     * @return window_state_t
+     */
+    inline window_state_t classifyWindow(bool minimized, bool foreground, uint64_t sinceInputMs, uint64_t idleAfterMs) {
+        if (minimized) {
+            return window_state_t::Minimized;
+        }
+        if (!foreground) {
+            return window_state_t::Background;
+        }
+        if (idleAfterMs != 0 && sinceInputMs >= idleAfterMs) {
+            return window_state_t::Idle;
+        }
+        return window_state_t::Foreground;
+    }
+
+    /**
+     * @brief Computes how long to wait to hold the capped frame rate
+     * @details Nothing is waited for in the foreground, otherwise whatever is left of the
+     *      capped frame interval that started at `frameStart`.
+     *
+     * @param state Current window state
+     * @param fps Frame rate cap outside the foreground
+     * @param frameStart Time the previous frame ended
+     * @param now Current time
+     * @return std::chrono::microseconds Time to wait, zero if none
+     */
+    inline std::chrono::microseconds capDelay(window_state_t state, int fps,
+        std::chrono::steady_clock::time_point frameStart, std::chrono::steady_clock::time_point now) {
+        if (state == window_state_t::Foreground) {
+            return std::chrono::microseconds(0);
+        }
+        auto frameEnd = frameStart + std::chrono::microseconds(1000000 / std::max(1, fps));
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(frameEnd - now);
+        return std::max(remaining, std::chrono::microseconds(0));
+    }
+
+    /**
+     * @brief Frame cap state carried from one frame to the next
+     * @details `step` is called once per frame with the latest observations and tells the
+     *      caller how long to wait and whether the state changed, so the change can be
+     *      logged. The cap follows the state of the frame being decided on, so it is lifted
+     *      on the very frame the window is back in use.
+     */
+    class FrameCap {
+    public:
+        /**
+         * @brief Outcome of a frame
+         */
+        typedef struct decision_t {
+            window_state_t state;
+            bool changed;
+            std::chrono::microseconds delay;
+        } decision_t;
+
+        /**
+         * @brief Decides on one frame
+         *
+         * @param minimized Whether the window is minimized
+         * @param foreground Whether the window is the foreground window
+         * @param sinceInputMs Milliseconds since the last input
+         * @param idleAfterMs Milliseconds without input after which the game is idle, 0 for never
+         * @param fps Frame rate cap outside the foreground
+         * @param frameStart Time the previous frame ended
+         * @param now Current time
+         * @return decision_t
+         */
+        decision_t step(bool minimized, bool foreground, uint64_t sinceInputMs, uint64_t idleAfterMs, int fps,
+            std::chrono::steady_clock::time_point frameStart, std::chrono::steady_clock::time_point now) {
+            window_state_t next = classifyWindow(minimized, foreground, sinceInputMs, idleAfterMs);
+            bool changed = next != state;
+            state = next;
+            return { state, changed, capDelay(state, fps, frameStart, now) };
+        }
+
+    private:
+        window_state_t state = window_state_t::Foreground;
+    };
+}
@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file memory_governor.hpp
+ * @brief Decisions of the memory governor.
+ *
+ * @details
+ * Unit tested on any platform, see tests/memory_governor_test.cpp. The governor works on
+ * samples the caller took and on the streaming settings in effect, so querying memory use
+ * and writing Engine.ini stay in main.cpp.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+namespace Utils
+{
+    /**
+     * @brief Memory use observed at one sample
+     */
+    typedef struct memory_sample_t {
+        // System memory load in percent
+        int load = 0;
+        // Local video memory in use is beyond the budget the OS grants the game
+        bool videoOverBudget = false;
+        // Local video memory in use leaves room below that budget
+        bool videoHeadroom = true;
+    } memory_sample_t;
+
+    /**
+     * @brief Texture streaming settings the governor steers
+     */
+    typedef struct memory_settings_t {
+        // r.Streaming.PoolSize in MB
+        int poolSize = 0;
+        // r.Streaming.MipBias, mip levels dropped from every streamed texture
+        int mipBias = 0;
+
+        bool operator==(const memory_settings_t&) const = default;
+    } memory_settings_t;
+
+    /**
+     * @brief Thresholds and bounds of the governor
+     */
+    typedef struct memory_limits_t {
+        int samples = 3;
+        int high = 90;
+        int low = 75;
+        int step = 500;
+        int minPoolSize = 1000;
+        int maxPoolSize = 4000;
+        int maxMipBias = 1;
+    } memory_limits_t;
+
+    /**
+     * @brief Settings one step lighter on memory
+     * @details The pool shrinks first, by `step` down to `minPoolSize`; only a pool that is
+     *      already at its minimum raises the mip bias, up to `maxMipBias`.
+     *
+     * @param settings Settings in effect
+     * @param limits Bounds to keep to
+     * @return memory_settings_t The same settings if nothing can be lowered
+     */
+    inline memory_settings_t lowerMemory(memory_settings_t settings, const memory_limits_t& limits) {
+        if (settings.poolSize > limits.minPoolSize) {
+            settings.poolSize = std::max(limits.minPoolSize, settings.poolSize - limits.step);
+        }
+        else if (settings.mipBias < limits.maxMipBias) {
+            settings.mipBias++;
+        }
+        return settings;
+    }
+
+    /**
+     * @brief Settings one step heavier on memory, undoing `lowerMemory` in reverse order
+     *
+     * @param settings Settings in effect
+     * @param limits Bounds to keep to
+     * @return memory_settings_t The same settings if nothing can be raised
+     */
+    inline memory_settings_t raiseMemory(memory_settings_t settings, const memory_limits_t& limits) {
+        if (settings.mipBias > 0) {
+            settings.mipBias--;
+        }
+        else {
+            settings.poolSize = std::min(limits.maxPoolSize, settings.poolSize + limits.step);
+        }
+        return settings;
+    }
+
+    /**
+     * @brief Steps the streaming settings with hysteresis
+     * @details Only after `samples` samples in a row at or above `high` percent load, or
+     *      with video memory over budget, are the settings lowered one step, and only after
+     *      as many at or below `low` percent with video memory to spare are they raised
+     *      one step, so a short spike while loading an area causes no adjustment. Both
+     *      counts start over after an adjustment.
+     */
+    class MemoryGovernor {
+    public:
+        explicit MemoryGovernor(memory_limits_t limits) : limits(limits) {}
+
+        /**
+         * @brief Takes one sample into account
+         *
+         * @param sample Memory use observed
+         * @param settings Settings in effect
+         * @return memory_settings_t Settings to use, equal to `settings` if they stay
+         */
+        memory_settings_t step(const memory_sample_t& sample, const memory_settings_t& settings) {
+            samplesHigh = sample.load >= limits.high || sample.videoOverBudget ? samplesHigh + 1 : 0;
+            samplesLow = sample.load <= limits.low && sample.videoHeadroom ? samplesLow + 1 : 0;
+            memory_settings_t next = settings;
+            if (samplesHigh >= limits.samples) {
+                next = lowerMemory(settings, limits);
+            }
+            else if (samplesLow >= limits.samples) {
+                next = raiseMemory(settings, limits);
+            }
+            if (next != settings) {
+                samplesHigh = 0;
+                samplesLow = 0;
+            }
+            return next;
+        }
+
+    private:
+        memory_limits_t limits;
+        int samplesHigh = 0;
+        int samplesLow = 0;
+    };
+}
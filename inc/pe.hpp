@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file pe.hpp
+ * @brief Parts of patching the executable that need neither Windows nor the game.
+ *
+ * @details
+ * Unit tested on any platform, see tests/pe_test.cpp. PE structures are read at the
+ * offsets the format defines instead of through windows.h. Only PE32+ images, which is
+ * what the game ships, are read.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Utils
+{
+    /**
+     * @brief A write of `size` bytes at `address`
+     */
+    typedef struct memory_range_t {
+        uintptr_t address;
+        size_t size;
+    } memory_range_t;
+
+    /**
+     * @brief Reads a little endian field of a PE structure
+     *
+     * @param base Start of the structure
+     * @param offset Offset of the field
+     * @return T
+     */
+    template <typename T>
+    inline T peRead(const uint8_t* base, size_t offset) {
+        T value;
+        memcpy(&value, base + offset, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Find the import address table slot of a function imported by name
+     * @details Walks the import descriptors of a module mapped at `module`. Names are read
+     *      from the import lookup table, or from the address table if the module has no
+     *      lookup table, and the slot at the same index of the address table is returned.
+     *      The DLL name is compared case insensitively, the function name exactly, as the
+     *      loader does. Functions imported by ordinal are skipped.
+     *
+     * @param module Base of the mapped module
+     * @param importModule Name of the DLL the function is imported from, e.g. "user32.dll"
+     * @param function Name of the imported function
+     * @return uint64_t* Slot holding the function's address, nullptr if not imported
+     */
+    inline uint64_t* findImportSlot(void* module, const char* importModule, const char* function) {
+        const uint16_t pe32PlusMagic = 0x20B;
+        const uint64_t ordinalFlag = 1ull << 63;
+        auto base = (uint8_t*)module;
+        auto nt = base + peRead<int32_t>(base, 0x3C);
+        // Signature and file header come first, the import directory is data directory 1
+        auto optional = nt + 24;
+        if (peRead<uint32_t>(nt, 0) != 0x4550 || peRead<uint16_t>(optional, 0) != pe32PlusMagic) {
+            return nullptr;
+        }
+        uint32_t directory = peRead<uint32_t>(optional, 112 + 8);
+        if (directory == 0) {
+            return nullptr;
+        }
+
+        auto equalNoCase = [](const char* a, const char* b) {
+            for (; *a && *b; a++, b++) {
+                if (std::tolower((unsigned char)*a) != std::tolower((unsigned char)*b)) {
+                    return false;
+                }
+            }
+            return *a == *b;
+        };
+        for (auto descriptor = base + directory; peRead<uint32_t>(descriptor, 12) != 0; descriptor += 20) {
+            if (!equalNoCase((const char*)base + peRead<uint32_t>(descriptor, 12), importModule)) {
+                continue;
+            }
+            uint32_t lookupTable = peRead<uint32_t>(descriptor, 0);
+            uint32_t addressTable = peRead<uint32_t>(descriptor, 16);
+            auto lookup = base + (lookupTable ? lookupTable : addressTable);
+            auto slot = (uint64_t*)(base + addressTable);
+            for (uint64_t entry; (entry = peRead<uint64_t>(lookup, 0)) != 0; lookup += 8, slot++) {
+                if (entry & ordinalFlag) {
+                    continue;
+                }
+                // Hint, then the name
+                if (strcmp((const char*)base + (uint32_t)entry + 2, function) == 0) {
+                    return slot;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Page aligned ranges that cover a set of writes
+     * @details Writes are sorted and every write is widened to the pages it touches.
+     *      Ranges that overlap or touch are merged, so writes to the same or adjacent
+     *      pages need a single protection change.
+     *
+     * @param writes Writes to cover, in any order
+     * @param pageSize Page size, a power of two
+     * @return std::vector<memory_range_t> Disjoint ranges in address order
+     */
+    inline std::vector<memory_range_t> pageRanges(std::vector<memory_range_t> writes, size_t pageSize) {
+        std::sort(writes.begin(), writes.end(),
+            [](const memory_range_t& a, const memory_range_t& b) { return a.address < b.address; }
+        );
+        std::vector<memory_range_t> ranges;
+        for (const auto& write : writes) {
+            if (write.size == 0) {
+                continue;
+            }
+            uintptr_t first = write.address & ~(uintptr_t)(pageSize - 1);
+            uintptr_t end = ((write.address + write.size - 1) | (pageSize - 1)) + 1;
+            if (!ranges.empty() && first <= ranges.back().address + ranges.back().size) {
+                uintptr_t last = std::max(ranges.back().address + ranges.back().size, end);
+                ranges.back().size = last - ranges.back().address;
+            }
+            else {
+                ranges.push_back({ first, end - first });
+            }
+        }
+        return ranges;
+    }
+}
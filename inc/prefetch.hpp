@@ -0,0 +1,233 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file prefetch.hpp
+ * @brief Plans which file ranges to prefetch from the reads of previous sessions.
+ *
+ * @details
+ * Unit tested on any platform, see tests/prefetch_test.cpp. Only the planning lives here;
+ * reading the ranges and watching the game's reads stays in main.cpp.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+    /**
+     * @brief Range of a file, with the earliest frame any read of it happened in
+     */
+    typedef struct file_range_t {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t frame;
+    } file_range_t;
+
+    /**
+     * @brief A range of a named file, as planned
+     */
+    typedef struct named_range_t {
+        std::string name;
+        file_range_t range;
+    } named_range_t;
+
+    /**
+     * @brief Prefetch plan built from a file trace
+     * @details Reads of the same file that overlap or lie within 64 KB of each other are
+     *      merged into one range, which keeps the earliest frame any of its reads happened
+     *      in. Every range is planned at most once and all plans share one byte budget.
+     *
+     *      `startup` plans the ranges first read early on, in order of that frame, so
+     *      whatever the game read first after starting is prefetched first. `follow` is for later reads: when the game
+     *      reads a traced range, e.g. on entering an area, the ranges first read within
+     *      `lookahead` frames after it in the trace are planned next.
+     */
+    class PrefetchPlan {
+    public:
+        /**
+         * @brief Builds the plan from a trace
+         *
+         * @param trace Contents of the trace, one `frame,thread,offset,size,ms,name` line per
+         *      read. The header and malformed lines are skipped
+         * @param budget Maximum number of bytes to plan over the plan's lifetime
+         */
+        PrefetchPlan(std::istream& trace, uint64_t budget) : remaining(budget) {
+            const uint64_t mergeGap = 64 * 1024;
+
+            // The name may itself contain commas, so only the first five are separators
+            std::map<std::string, std::vector<file_range_t>> files;
+            std::string line;
+            while (std::getline(trace, line)) {
+                size_t fields[5];
+                size_t position = 0;
+                bool valid = true;
+                for (auto& field : fields) {
+                    field = line.find(',', position);
+                    if (field == std::string::npos) {
+                        valid = false;
+                        break;
+                    }
+                    position = field + 1;
+                }
+                if (!valid) {
+                    continue;
+                }
+                try {
+                    file_range_t range;
+                    range.frame = std::stoull(line.substr(0, fields[0]));
+                    range.offset = std::stoull(line.substr(fields[1] + 1, fields[2] - fields[1] - 1));
+                    range.size = std::stoull(line.substr(fields[2] + 1, fields[3] - fields[2] - 1));
+                    if (range.size > 0) {
+                        files[line.substr(fields[4] + 1)].push_back(range);
+                    }
+                }
+                catch (const std::exception&) {
+                    continue;
+                }
+            }
+
+            for (auto& [name, reads] : files) {
+                std::sort(reads.begin(), reads.end(),
+                    [](const auto& a, const auto& b) { return a.offset < b.offset; }
+                );
+                file_range_t merged = reads[0];
+                for (size_t i = 1; i <= reads.size(); i++) {
+                    if (i < reads.size() && reads[i].offset <= merged.offset + merged.size + mergeGap) {
+                        merged.size = std::max(merged.size, reads[i].offset + reads[i].size - merged.offset);
+                        merged.frame = std::min(merged.frame, reads[i].frame);
+                        continue;
+                    }
+                    ranges.push_back({ name, merged });
+                    if (i < reads.size()) {
+                        merged = reads[i];
+                    }
+                }
+            }
+            std::stable_sort(ranges.begin(), ranges.end(),
+                [](const auto& a, const auto& b) { return a.range.frame < b.range.frame; }
+            );
+            planned.assign(ranges.size(), false);
+            followed.assign(ranges.size(), false);
+            // Ranges of a file do not overlap after merging, so they are indexed by offset
+            for (size_t i = 0; i < ranges.size(); i++) {
+                byFile[ranges[i].name].push_back(i);
+            }
+            for (auto& [name, indexes] : byFile) {
+                std::sort(indexes.begin(), indexes.end(),
+                    [this](size_t a, size_t b) { return ranges[a].range.offset < ranges[b].range.offset; }
+                );
+            }
+        }
+
+        /**
+         * @brief Plans the ranges read first after starting, within the budget
+         *
+         * @param frames Frames after starting to plan the ranges of
+         * @return std::vector<named_range_t> Ranges in the order to read them
+         */
+        std::vector<named_range_t> startup(uint64_t frames) {
+            std::vector<named_range_t> plan;
+            for (size_t i = 0; i < ranges.size() && ranges[i].range.frame <= frames && take(i, &plan); i++) {
+            }
+            return plan;
+        }
+
+        /**
+         * @brief Plans the ranges that followed a read in the trace
+         * @details Nothing is planned if the read is not within a traced range, or if
+         *      that range was already followed. The read's own range is being read by the
+         *      game, so it counts as planned without being returned.
+         *
+         * @param name Name of the file read
+         * @param offset Offset of the read
+         * @param lookahead Frames after the read's range to plan the ranges of
+         * @return std::vector<named_range_t> Ranges in the order to read them
+         */
+        std::vector<named_range_t> follow(const std::string& name, uint64_t offset, uint64_t lookahead) {
+            std::vector<named_range_t> plan;
+            auto file = byFile.find(name);
+            if (file == byFile.end()) {
+                return plan;
+            }
+            const std::vector<size_t>& indexes = file->second;
+            auto it = std::upper_bound(indexes.begin(), indexes.end(), offset,
+                [this](uint64_t value, size_t i) { return value < ranges[i].range.offset; }
+            );
+            if (it == indexes.begin()) {
+                return plan;
+            }
+            size_t index = *(it - 1);
+            if (offset >= ranges[index].range.offset + ranges[index].range.size || followed[index]) {
+                return plan;
+            }
+            followed[index] = true;
+            planned[index] = true;
+            uint64_t last = ranges[index].range.frame + lookahead;
+            for (size_t i = index + 1; i < ranges.size() && ranges[i].range.frame <= last; i++) {
+                if (!planned[i] && !take(i, &plan)) {
+                    break;
+                }
+            }
+            return plan;
+        }
+
+        /**
+         * @brief Bytes left in the budget
+         *
+         * @return uint64_t
+         */
+        uint64_t budget() const { return remaining; }
+
+        /**
+         * @brief Number of ranges in the trace, after merging
+         *
+         * @return size_t
+         */
+        size_t size() const { return ranges.size(); }
+
+    private:
+        bool take(size_t index, std::vector<named_range_t>* plan) {
+            if (ranges[index].range.size > remaining) {
+                return false;
+            }
+            remaining -= ranges[index].range.size;
+            planned[index] = true;
+            plan->push_back(ranges[index]);
+            return true;
+        }
+
+        std::vector<named_range_t> ranges;
+        std::map<std::string, std::vector<size_t>> byFile;
+        std::vector<bool> planned;
+        std::vector<bool> followed;
+        uint64_t remaining;
+    };
+}
@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file tuner.hpp
+ * @brief Search core of the settings tuner.
+ *
+ * @details
+ * Unit tested on any platform against a synthetic cost model, see tests/tuner_test.cpp.
+ * The search only sees value indexes, their quality and the scores it is given; which
+ * console variables they stand for, running the benchmark and keeping the state across
+ * launches stay in main.cpp.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+    /**
+     * @brief Search space of the tuner
+     */
+    typedef struct tuner_space_t {
+        // Number of values of every parameter
+        std::vector<size_t> sizes;
+        // Quality of every value of every parameter, in percent; missing qualities are 100
+        std::vector<std::vector<double>> quality;
+        // Points whose average quality is lower are never tested
+        double qualityFloor = 0.0;
+        // Passes over all parameters at most
+        int passes = 2;
+    } tuner_space_t;
+
+    /**
+     * @brief Progress of the search, kept across launches
+     */
+    typedef struct tuner_state_t {
+        std::vector<int> current;
+        std::vector<int> best;
+        size_t parameter = 0;
+        int value = 0;
+        int pass = 0;
+        bool improved = false;
+        bool applied = false;
+        bool done = false;
+        std::map<std::string, double> scores;
+    } tuner_state_t;
+
+    /**
+     * @brief Key of a point in the search space, the value index of every parameter
+     *
+     * @param point Value index of every parameter
+     * @return std::string
+     */
+    inline std::string tunerKey(const std::vector<int>& point) {
+        std::string key;
+        for (int index : point) {
+            key += (key.empty() ? "" : ",") + std::to_string(index);
+        }
+        return key;
+    }
+
+    /**
+     * @brief Quality of a point, the average quality of its values
+     *
+     * @param space Search space
+     * @param point Value index of every parameter
+     * @return double Quality in percent
+     */
+    inline double tunerQuality(const tuner_space_t& space, const std::vector<int>& point) {
+        if (point.empty()) {
+            return 100.0;
+        }
+        double total = 0.0;
+        for (size_t i = 0; i < point.size(); i++) {
+            bool known = i < space.quality.size() && (size_t)point[i] < space.quality[i].size();
+            total += known ? space.quality[i][point[i]] : 100.0;
+        }
+        return total / point.size();
+    }
+
+    /**
+     * @brief Starts the search at the first value of every parameter
+     * @details List the values of every parameter from the highest quality down, so the
+     *      starting point is the one most likely to be above the quality floor. If it is
+     *      not, or there is nothing to search, no point is tested and the search is done
+     *      right away.
+     *
+     * @param state Search state to reset
+     * @param space Search space
+     * @return bool False if the starting point is below the quality floor
+     */
+    inline bool tunerStart(tuner_state_t& state, const tuner_space_t& space) {
+        state = tuner_state_t{};
+        state.current.assign(space.sizes.size(), 0);
+        state.best = state.current;
+        state.done = space.sizes.empty() || tunerQuality(space, state.current) < space.qualityFloor;
+        return !state.done;
+    }
+
+    /**
+     * @brief Moves the coordinate descent to the next point that has to be scored
+     * @details Each parameter in turn is swept through all of its values while every other
+     *      parameter is held at the best point found so far; after the sweep the best value
+     *      is kept and the next parameter is swept. A pass over all parameters is repeated
+     *      while it still improved the best point, up to `passes` passes. Points that were
+     *      scored before, or are below the quality floor, are skipped, so only new
+     *      acceptable combinations cost a run. The search depends only on the scores, so
+     *      the same scores always lead to the same sequence of points.
+     *
+     * @param state Search state, `current` receives the next point to score
+     * @param space Search space
+     * @return bool False once the search is done, `current` is then the best point
+     */
+    inline bool tunerAdvance(tuner_state_t& state, const tuner_space_t& space) {
+        if (space.sizes.empty()) {
+            state.done = true;
+            return false;
+        }
+        while (true) {
+            state.value++;
+            if (state.value >= (int)space.sizes[state.parameter]) {
+                state.value = 0;
+                state.parameter++;
+            }
+            if (state.parameter >= space.sizes.size()) {
+                state.parameter = 0;
+                state.pass++;
+                if (!state.improved || state.pass >= space.passes) {
+                    state.done = true;
+                    state.current = state.best;
+                    return false;
+                }
+                state.improved = false;
+            }
+            std::vector<int> candidate = state.best;
+            candidate[state.parameter] = state.value;
+            if (!state.scores.contains(tunerKey(candidate)) && tunerQuality(space, candidate) >= space.qualityFloor) {
+                state.current = candidate;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @brief Records the score of the current point and picks the next one
+     *
+     * @param state Search state
+     * @param space Search space
+     * @param score Score of `current`, higher is better
+     * @return bool False once the search is done
+     */
+    inline bool tunerRecord(tuner_state_t& state, const tuner_space_t& space, double score) {
+        state.scores[tunerKey(state.current)] = score;
+        auto best = state.scores.find(tunerKey(state.best));
+        if (best == state.scores.end() || score > best->second) {
+            state.improved = state.improved || best != state.scores.end();
+            state.best = state.current;
+        }
+        return tunerAdvance(state, space);
+    }
+}
@@ -27,9 +27,27 @@
 #include <windows.h>
 #include <vector>
 #include <string>
+#include <functional>
+#include <coroutine>
+#include <exception>
+#include <atomic>
+#include <mutex>
+#include <array>
+
+#include "pe.hpp"
 
 namespace Utils
 {
+    /**
+     * @brief A single decoded x86_64 instruction
+     */
+    typedef struct instruction_t {
+        uintptr_t address;
+        size_t length;
+        std::string mnemonic;
+        std::string text;
+    } instruction_t;
+
     /**
      * @brief Retrieves information about the compiler being used.
      * @details This function returns a string containing the name and version of the
@@ -103,4 +121,628 @@ namespace Utils
      * @param address Vector of addresses where the pattern was found
      */
     void patternScan(void* module, const char* signature, std::vector<uint64_t>* address);
+
+    /**
+     * @brief Scan part of a module for a given byte pattern
+     * @details Same as `patternScan`, but only hits starting in [begin, end) are found.
+     *      A hit may extend past `end`. Used to rescan just the pages that changed.
+     *
+     * @param module Base of the module to search
+     * @param signature IDA-style byte array pattern
+     * @param begin Relative address of the first position to test
+     * @param end Relative address one past the last position to test
+     * @param address Vector of addresses where the pattern was found
+     */
+    void patternScan(void* module, const char* signature, uintptr_t begin, uintptr_t end, std::vector<uint64_t>* address);
+
+    /**
+     * @brief Check whether a byte pattern matches at an address
+     *
+     * @param address Address of the first byte to compare
+     * @param signature IDA-style byte array pattern
+     * @return bool True if every non-wildcard byte matches
+     */
+    bool patternMatch(uintptr_t address, const char* signature);
+
+    /**
+     * @brief How robust and how cheap to scan a signature is
+     */
+    typedef struct signature_stats_t {
+        size_t nearMissDistance;
+        size_t nearMisses;
+        uint64_t nearMissAddress;
+        int anchorByte;
+        size_t anchorCount;
+        size_t rarestOffset;
+        int rarestByte;
+        size_t rarestCount;
+        size_t uniqueLength;
+        std::string suggestion;
+        size_t suggestionOffset;
+        size_t suggestionCount;
+    } signature_stats_t;
+
+    /**
+     * @brief Measure how close a signature is to becoming ambiguous
+     * @details Walks the module in the same chunks as `patternScan`, on the shared thread
+     *      pool. Every position that is not a hit is compared against the signature:
+     *      - `nearMissDistance` is the fewest non-wildcard bytes any of them differs in,
+     *        `nearMisses` how many positions differ by that much and `nearMissAddress`
+     *        the first of them. A distance of 1 means a single changed byte in a game
+     *        update makes the signature ambiguous.
+     *      - `anchorByte` is the first non-wildcard byte and `anchorCount` how often it
+     *        occurs in the module; a common anchor makes the scan test many candidates.
+     *        `rarestByte`, at `rarestOffset`, is the least common byte of the signature
+     *        and would be the cheapest anchor.
+     *      - `uniqueLength` is the length of the shortest prefix of the signature that
+     *        still matches only the hits; anything past it adds scan cost but no
+     *        uniqueness. It is the full length if every byte is needed.
+     *      - `suggestion` is a cheaper signature that still matches only the hits, empty
+     *        if none was found. It starts `suggestionOffset` bytes into the signature, so
+     *        a fix switching to it subtracts that from its patch offsets, and its first
+     *        byte occurs `suggestionCount` times in the module. Windows starting at the
+     *        bytes rarer than the anchor are tried, rarest first, each cut to the
+     *        shortest length that is still unique; the unique prefix is the fallback.
+     *      Takes one or two full passes over the module, meant for debugging signatures.
+     *
+     * @param module Base of the module to search
+     * @param signature IDA-style byte array pattern
+     * @return signature_stats_t
+     */
+    signature_stats_t analyzeSignature(void* module, const char* signature);
+
+    /**
+     * @brief Writes to the executable's memory, applied together
+     * @details Writes are collected with `add` and applied by `commit`. The pages they
+     *      touch are merged into ranges with `pageRanges` and each range is split where
+     *      its protection changes, so writes close together share one `VirtualProtect`
+     *      call to make them writable and one to restore the protection. The instruction
+     *      cache is flushed once per range. Nothing is written until `commit`, so a fix
+     *      can stage several sites and apply none if one of them fails validation.
+     *
+     * @code
+     * PatchBatch batch;
+     * batch.add(first, bytes, sizeof(bytes));
+     * batch.add(second, bytes, sizeof(bytes));
+     * batch.commit(); // One protection change if both are in the same page
+     * @endcode
+     */
+    class PatchBatch {
+    public:
+        /**
+         * @brief Stage a write
+         *
+         * @param address Address of the first byte to write
+         * @param bytes Bytes to write, copied
+         * @param size Number of bytes
+         */
+        void add(uintptr_t address, const void* bytes, size_t size);
+
+        /**
+         * @brief Apply every staged write and clear the batch
+         *
+         * @return bool True if every range could be made writable
+         */
+        bool commit();
+
+        /**
+         * @brief Number of staged writes
+         *
+         * @return size_t
+         */
+        size_t size() const { return writes.size(); }
+
+    private:
+        typedef struct write_t {
+            uintptr_t address;
+            std::vector<uint8_t> bytes;
+        } write_t;
+
+        std::vector<write_t> writes;
+    };
+
+    /**
+     * @brief Redirect a function imported by a module
+     * @details Rewrites the slot of `function` in the import address table of `module`,
+     *      found with `findImportSlot`. Every call the module makes through the import
+     *      goes to `detour` instead, at no cost beyond the redirect itself since the call
+     *      was already indirect. Calls from other modules, or through `GetProcAddress`,
+     *      are not affected. To undo the hook, hook again with the returned original.
+     *      With a `batch` the slot is only written by its `commit`, so several hooks share
+     *      one protection change and the originals can be stored before any detour runs.
+     *
+     * @param module Base of the module whose imports are rewritten
+     * @param importModule Name of the DLL the function is imported from, e.g. "user32.dll"
+     * @param function Name of the imported function
+     * @param detour Function to call instead
+     * @param batch Batch to stage the write in, nullptr to write right away
+     * @return void* Address previously in the slot, nullptr if the import was not found
+     *
+     * @code
+     * static decltype(&Sleep) originalSleep = (decltype(&Sleep))hookIat(
+     *     baseModule, "kernel32.dll", "Sleep", (void*)detourSleep
+     * );
+     * @endcode
+     */
+    void* hookIat(void* module, const char* importModule, const char* function, void* detour, PatchBatch* batch = nullptr);
+
+    /**
+     * @brief Find the function containing an address
+     * @details Binary searches the module's exception directory (.pdata), which the
+     *      compiler emits for every non-leaf function on x64, sorted by start address.
+     *      Lookups are O(log n) and need no preprocessing. Leaf functions without
+     *      unwind info are not found.
+     *
+     * @param module Base of the module
+     * @param rva Relative address to look up
+     * @param begin Receives the relative start address of the function
+     * @param end Receives the relative end address of the function
+     * @return bool True if a function containing `rva` was found
+     */
+    bool findFunction(void* module, uintptr_t rva, uintptr_t* begin, uintptr_t* end);
+
+    /**
+     * @brief Hash a block of memory
+     * @details Fast non-cryptographic 64-bit hash. The input is consumed as four
+     *      independent lanes of 64-bit words so the multiplies can run in parallel,
+     *      which keeps hashing whole 4 KB pages of the executable cheap. Only meant
+     *      for detecting changed bytes, not for security.
+     *
+     * @param data Pointer to memory
+     * @param size Number of bytes to hash
+     * @return uint64_t
+     */
+    uint64_t hashBytes(const void* data, size_t size);
+
+    /**
+     * @brief Hash a range of a loaded module as it is on disk
+     * @details Like `hashBytes`, but every byte the loader rewrote while applying base
+     *      relocations (.reloc) is hashed as zero. The result is therefore the same
+     *      whatever address ASLR loaded the module at, and matches a hash of the file's
+     *      mapped sections. The .reloc blocks of a module are indexed by page on first
+     *      use; only the blocks of the pages in the range are decoded. It exists for the
+     *      offset cache's build fingerprint and page hashes, which must not change with
+     *      the load address; it works on the loaded module only, nothing maps the file.
+     *
+     * @param module Base of the module
+     * @param rva Relative address of the first byte
+     * @param size Number of bytes to hash
+     * @return uint64_t
+     */
+    uint64_t hashImage(void* module, uintptr_t rva, size_t size);
+
+    /**
+     * @brief Hash every 4 KB page of a loaded module as it is on disk
+     * @details `hashImage` of each page, on the shared thread pool.
+     *
+     * @param module Base of the module
+     * @return std::vector<uint64_t> One hash per page, indexed by RVA / 4 KB
+     */
+    std::vector<uint64_t> hashPages(void* module);
+
+    /**
+     * @brief Fingerprint the build of a loaded module
+     * @details Identifies an executable cheaply enough to run on every launch, without
+     *      hashing the whole image. The fingerprint combines:
+     *      - PE header fields: TimeDateStamp, CheckSum, SizeOfImage, SizeOfCode and
+     *        AddressOfEntryPoint
+     *      - a hash of the whole section table
+     *      - hashes of 16 evenly spaced 4 KB pages of every executable section
+     *      Only executable sections are sampled, since writable data is already being
+     *      modified by the game by the time this runs. Pages are hashed with `hashImage`
+     *      so the fingerprint does not depend on the load address.
+     *
+     * @param module Base of the module
+     * @return uint64_t
+     */
+    uint64_t fingerprintModule(void* module);
+
+    /**
+     * @brief Decode instructions starting at an address
+     * @details Decodes up to `count` consecutive instructions with Zydis in 64-bit mode.
+     *      Decoding stops early at the first invalid instruction. Used to check that a
+     *      signature hit really lands on the expected code before it gets hooked or
+     *      patched, and to log what is being modified.
+     *
+     * @param address Address of the first instruction
+     * @param count Maximum number of instructions to decode
+     * @return std::vector<instruction_t>
+     *
+     * @code
+     * // F3 0F 10 81 9C 03 00 00 0F 57 C9
+     * auto instructions = decodeInstructions(address, 2);
+     * std::cout << instructions[1].text << std::endl; // Prints "xorps xmm1, xmm1"
+     * @endcode
+     */
+    std::vector<instruction_t> decodeInstructions(uintptr_t address, size_t count);
+
+    /**
+     * @brief Every instruction of a module's executable sections, decoded once
+     * @details Structure of arrays, one entry per instruction in address order: its RVA,
+     *      length, Zydis instruction category and, for RIP-relative branches and memory
+     *      operands, the RVA it refers to (0 otherwise). `build` sweeps the executable
+     *      sections linearly in 1 MB chunks on the shared thread pool; every chunk starts
+     *      decoding at its own start and is spliced onto the previous one where the two
+     *      agree on an instruction boundary, so the result equals a serial sweep. Bytes
+     *      that do not decode are skipped one at a time. The table is stored in the same
+     *      layout it is saved in, so `load` maps the file and reads it in place.
+     */
+    class InstructionTable {
+    public:
+        InstructionTable() = default;
+        InstructionTable(const InstructionTable&) = delete;
+        InstructionTable& operator=(const InstructionTable&) = delete;
+        ~InstructionTable();
+
+        /**
+         * @brief Decode the module, replacing any previous contents
+         *
+         * @param module Base of the module to decode
+         * @param key Identity of the module, stored with the table and checked by `load`
+         */
+        void build(void* module, uint64_t key);
+
+        /**
+         * @brief Map a table saved by `save`
+         *
+         * @param path File to map
+         * @param key Identity the table must have been built for
+         * @return bool True if the file exists, is intact and matches `key`
+         */
+        bool load(const std::string& path, uint64_t key);
+
+        /**
+         * @brief Write the table to a file, atomically replacing it
+         *
+         * @param path File to write
+         * @return bool True on success
+         */
+        bool save(const std::string& path) const;
+
+        /**
+         * @brief Find the instruction containing an RVA
+         *
+         * @param rva Relative address to look up
+         * @return size_t Index of the instruction, SIZE_MAX if no instruction covers `rva`
+         */
+        size_t find(uint32_t rva) const;
+
+        size_t size() const { return header ? (size_t)header->count : 0; }
+        uint32_t offset(size_t i) const { return offsets[i]; }
+        uint32_t target(size_t i) const { return targets[i]; }
+        uint8_t length(size_t i) const { return lengths[i]; }
+        uint8_t category(size_t i) const { return categories[i]; }
+
+    private:
+        typedef struct header_t {
+            char magic[4];
+            uint32_t version;
+            uint64_t key;
+            uint64_t count;
+        } header_t;
+
+        void attach(const uint8_t* data);
+        void release();
+
+        std::vector<uint8_t> storage;
+        HANDLE mapping = NULL;
+        const uint8_t* view = nullptr;
+        const header_t* header = nullptr;
+        const uint32_t* offsets = nullptr;
+        const uint32_t* targets = nullptr;
+        const uint8_t* lengths = nullptr;
+        const uint8_t* categories = nullptr;
+    };
+
+    /**
+     * @brief Set the maximum number of worker threads of the shared thread pool
+     * @details All parallel work in the project goes through one process wide Windows
+     *      thread pool so that nothing spawns its own threads and oversubscribes the
+     *      cores while the game is starting. Workers run callbacks below normal thread
+     *      priority, so they yield to the game's threads.
+     *      Must be called before the first call to `parallelFor` to take effect.
+     *
+     * @param maxWorkers Maximum number of workers, 0 uses all available cores
+     */
+    void setWorkerLimit(unsigned int maxWorkers);
+
+    /**
+     * @brief Run `task` for every index in [0, count) on the shared thread pool
+     * @details Fork-join helper: the indices are split into one deque per participant,
+     *      the calling thread being one of them. Each takes indices from the front of its
+     *      own deque and, once it is empty, steals the back half of another's, so uneven
+     *      tasks still keep every worker busy. Returns once every index has been
+     *      processed. Tasks for different indices must not depend on each other.
+     *
+     * @param count Number of indices
+     * @param task Function called once per index
+     *
+     * @code
+     * std::vector<int> squares(100);
+     * parallelFor(squares.size(), [&](size_t i) { squares[i] = i * i; });
+     * @endcode
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    /**
+     * @brief Run `task` once on the shared thread pool without waiting for it
+     * @details Meant for hooks that must hand work such as logging or file writes off
+     *      the game's threads. Returns immediately.
+     *
+     * @param task Function to run
+     */
+    void runAsync(std::function<void()> task);
+
+    /**
+     * @brief Fixed size lock-free single producer, single consumer queue
+     * @details One thread, typically a hook, pushes and one other thread pops. Neither
+     *      side ever blocks: when the queue is full the new item is dropped and counted,
+     *      so a slow consumer can never stall the game.
+     *
+     * @tparam T Item type, should be trivially copyable
+     * @tparam N Capacity, must be a power of two
+     */
+    template <typename T, size_t N>
+    class RingBuffer {
+        static_assert(N != 0 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+    public:
+        /**
+         * @brief Append an item, producer side
+         *
+         * @param item Item to append
+         * @return bool False if the queue was full and the item was dropped
+         */
+        bool push(const T& item) {
+            size_t head = this->head.load(std::memory_order_relaxed);
+            if (head - tail.load(std::memory_order_acquire) == N) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            items[head & (N - 1)] = item;
+            this->head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Remove the oldest item, consumer side
+         *
+         * @param item Receives the removed item
+         * @return bool False if the queue was empty
+         */
+        bool pop(T& item) {
+            size_t tail = this->tail.load(std::memory_order_relaxed);
+            if (tail == head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            item = items[tail & (N - 1)];
+            this->tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Number of items dropped because the queue was full, resets the count
+         *
+         * @return size_t
+         */
+        size_t takeDropped() {
+            return dropped.exchange(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<T, N> items{};
+        alignas(64) std::atomic<size_t> head = 0;
+        alignas(64) std::atomic<size_t> tail = 0;
+        std::atomic<size_t> dropped = 0;
+    };
+
+    /**
+     * @brief Return type of a fire-and-forget coroutine
+     * @details A function returning `Task` runs until its first `co_await` on an `Event`
+     *      that is not yet signaled, then returns to the caller. It is resumed on the
+     *      thread that signals the event and cleans itself up when it finishes, so the
+     *      caller never has to keep hold of it.
+     *
+     * @code
+     * Utils::Task waitForCamera() {
+     *     co_await cameraReady;
+     *     LOG("Camera exists");
+     * }
+     * @endcode
+     */
+    struct Task {
+        struct promise_type {
+            Task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    /**
+     * @brief One-shot event that coroutines can `co_await`
+     * @details Once `signal` is called the event stays set: every coroutine waiting on
+     *      it is resumed on the signaling thread and later `co_await`s continue straight
+     *      away. Nothing polls or sleeps while waiting; the suspended coroutine is only
+     *      a handle stored in the event. Hooks are expected to call `signal`, so keep
+     *      the awaiting code short or hand heavy work to `parallelFor`.
+     */
+    class Event {
+    public:
+        Event() = default;
+        Event(const Event&) = delete;
+        Event& operator=(const Event&) = delete;
+
+        bool await_ready() const noexcept { return set.load(std::memory_order_acquire); }
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const noexcept {}
+
+        /**
+         * @brief Set the event and resume every waiting coroutine
+         */
+        void signal();
+
+        /**
+         * @brief Check whether the event has been signaled
+         *
+         * @return bool
+         */
+        bool isSet() const { return set.load(std::memory_order_acquire); }
+
+    private:
+        std::atomic<bool> set = false;
+        std::mutex mutex;
+        std::vector<std::coroutine_handle<>> waiters;
+    };
+
+    /**
+     * @brief Get the event that is signaled when a module is loaded into the process
+     * @details Uses the loader's DLL notification callback, so the event is delivered by
+     *      the loader itself as soon as the module is mapped. If the module is already
+     *      loaded the returned event is signaled already. The name is compared case
+     *      insensitively against the module's file name, e.g. "dxgi.dll".
+     *
+     * @param name File name of the module
+     * @return Event& Event that lives for the lifetime of the process
+     */
+    Event& moduleLoaded(const std::wstring& name);
+
+    /**
+     * @brief A range of memory that differs between two snapshots
+     */
+    typedef struct memory_change_t {
+        uintptr_t address;
+        size_t size;
+        uint32_t oldValue;
+        uint32_t newValue;
+    } memory_change_t;
+
+    /**
+     * @brief Copy of every writable region of the process at one point in time
+     * @details Used to find where the game keeps a value: take a snapshot, change the
+     *      setting in game, take another snapshot and `diff` the two. Copies are made
+     *      with `ReadProcessMemory` so a region freed mid-copy is skipped instead of
+     *      crashing, and regions are copied on the shared thread pool. The buffers of
+     *      every live snapshot are excluded from new snapshots.
+     *      The copies are full, not copy-on-write: Windows can only share pages
+     *      copy-on-write through a section object, and the game's heaps are private
+     *      memory it allocated itself. A snapshot therefore takes as much memory as the
+     *      regions it covers, and the baseline plus a new snapshot about twice that.
+     */
+    class MemorySnapshot {
+    public:
+        MemorySnapshot() = default;
+        MemorySnapshot(const MemorySnapshot&) = delete;
+        MemorySnapshot& operator=(const MemorySnapshot&) = delete;
+        MemorySnapshot(MemorySnapshot&& other) noexcept;
+        MemorySnapshot& operator=(MemorySnapshot&& other) noexcept;
+        ~MemorySnapshot();
+
+        /**
+         * @brief Take the snapshot, replacing any previous contents
+         */
+        void take();
+
+        /**
+         * @brief Compare with a newer snapshot
+         * @details Only regions present at the same address and size in both snapshots
+         *      are compared, in 1 MB chunks on the shared thread pool. Differences are
+         *      reported at 4 byte granularity, adjacent differences merged into one
+         *      range. `oldValue` and `newValue` hold the first 4 bytes of each range so
+         *      they can be read as an int or a float.
+         *
+         * @param newer Snapshot taken after this one
+         * @return std::vector<memory_change_t> Changed ranges sorted by address
+         */
+        std::vector<memory_change_t> diff(const MemorySnapshot& newer) const;
+
+        /**
+         * @brief Total number of bytes copied
+         *
+         * @return size_t
+         */
+        size_t size() const;
+
+    private:
+        typedef struct region_t {
+            uintptr_t base;
+            size_t size;
+            uint8_t* copy;
+        } region_t;
+
+        void release();
+
+        std::vector<region_t> regions;
+    };
+
+    /**
+     * @brief Totals of one instrumented region since the last `takeRegionStats`
+     */
+    typedef struct region_stats_t {
+        const char* name;
+        uint64_t calls;
+        double ms;
+        uint64_t cycles;
+    } region_stats_t;
+
+    /**
+     * @brief Named region of code whose wall time and CPU cycles are accumulated
+     * @details Declare one as a function local static and open a `Scope` on it around
+     *      the code to measure. Wall time comes from `QueryPerformanceCounter`, cycles
+     *      from `QueryThreadCycleTime`, which counts only the cycles the thread actually
+     *      ran for. Comparing the two tells whether a region was busy on the CPU or was
+     *      waiting, e.g. on page faults, I/O or the scheduler. Scopes cost a few hundred
+     *      nanoseconds and do nothing until `enableRegions` is called.
+     *
+     * @code
+     * static Utils::Region region("scanSignature");
+     * Utils::Region::Scope scope(region);
+     * @endcode
+     */
+    class Region {
+    public:
+        explicit Region(const char* name);
+        Region(const Region&) = delete;
+        Region& operator=(const Region&) = delete;
+
+        /**
+         * @brief Measures from construction to destruction and adds to the region
+         */
+        class Scope {
+        public:
+            explicit Scope(Region& region);
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+            ~Scope();
+
+        private:
+            Region& region;
+            bool active;
+            int64_t startTicks = 0;
+            uint64_t startCycles = 0;
+        };
+
+    private:
+        friend std::vector<region_stats_t> takeRegionStats();
+
+        const char* name;
+        std::atomic<uint64_t> calls = 0;
+        std::atomic<int64_t> ticks = 0;
+        std::atomic<uint64_t> cycles = 0;
+    };
+
+    /**
+     * @brief Start or stop measuring every `Region`
+     *
+     * @param enable True to measure
+     */
+    void enableRegions(bool enable);
+
+    /**
+     * @brief Totals of every region that ran since the previous call, resets them
+     *
+     * @return std::vector<region_stats_t> One entry per region with at least one call
+     */
+    std::vector<region_stats_t> takeRegionStats();
 }
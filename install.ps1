@@ -43,11 +43,16 @@ $fullPath = "$gameFolder\$gameSubFolder\$scriptsFolder"
 $fixName = "CodeVeinFix"
 
 $ymlFileContent = @"
+# Every setting is optional, a missing setting uses the default value shown here.
 name: Code Vein Fix
 
 # Enables or disables all fixes
 masterEnable: true
 
+# Maximum number of threads used for scanning.
+# A value of 0 will use all available cores.
+threads: 0
+
 # Enter desired resolution.
 # A value of 0 in either width or height will use your desktop's resolution.
 resolution:
@@ -67,6 +72,143 @@ fixes:
   fov:
     enable: true
     value: 68
+
+
+  # If enabled the frame rate is capped to `fps` while the game is minimized or in the background.
+  # With `idle` above 0 it is also capped once there was no keyboard, mouse or gamepad input
+  # for `idle` seconds, e.g. while left in a menu, until the next input. Cutscenes get no
+  # input either, so keep `idle` longer than they are.
+  backgroundCap:
+    enable: false
+    fps: 15
+    idle: 0
+
+
+  # If enabled quitting skips the game's slow shutdown. Saves still being written are waited
+  # for, the whole exit takes at most `timeout` milliseconds.
+  fastExit:
+    enable: false
+    timeout: 3000
+
+# Per resolution settings, used when the game runs at a matching resolution. A profile
+# without width and height is keyed by `aspectRatio` instead and used for every resolution
+# within 0.5% of it; a profile for the exact resolution wins. The aspect ratio bytes and FOV
+# of every profile are prepared at startup, switching displays applies them instantly.
+# profiles:
+#   - width: 3440
+#     height: 1440
+#     fov: 72
+#   - aspectRatio: "32:9"
+#     fov: 76
+profiles: []
+
+# If enabled frame time statistics will be written to the log every `interval` seconds,
+# with the CPU time per frame of the game and render threads and which of them, or the GPU,
+# holds the frame rate back.
+telemetry:
+  enable: false
+  interval: 10
+
+# If enabled the file ranges recorded by `fileTrace` in previous sessions are read ahead
+# of time at low priority, up to `budget` MB, so they are already cached when needed. The
+# ranges read first after starting are read at startup. With `fileTrace` enabled, a read of
+# a recorded range, e.g. on entering an area, also reads what followed it last time.
+prefetch:
+  enable: false
+  budget: 512
+
+# If enabled F10 starts a benchmark, press it once the game is where it should be measured.
+# With `start` above 0 it also starts on its own `start` seconds after the game's camera
+# exists, which the FOV fix detects; the title screen has one too, so leave enough time to
+# load into the scene to measure. After waiting `delay` seconds, frame times and the CPU
+# time of the game and render threads are recorded for `duration` seconds. Frames longer
+# than `hitch` times the median count as hitches. The results are logged and appended to
+# CodeVeinFix.benchmark.csv under `label`, then the game closes if `exit` is enabled.
+benchmark:
+  enable: false
+  label: ""
+  start: 0
+  delay: 10
+  duration: 60
+  hitch: 2.5
+  exit: false
+
+# If enabled system and video memory use is sampled every `interval` seconds. The game's video
+# memory stands in for the texture streaming pool's usage, which can not be read. Once the
+# memory load stays at or above `high` percent, or video memory over its budget, for `samples`
+# samples in a row, the texture streaming pool (r.Streaming.PoolSize in Engine.ini) is lowered
+# by `step` MB, down to `minPoolSize`; past that, the mip bias (r.Streaming.MipBias) is raised
+# by one, up to `maxMipBias`, dropping the finest mip of every streamed texture. Once memory
+# stays at or below `low` percent with video memory to spare, the mip bias and then the pool
+# are raised again, up to `maxPoolSize`. The engine only reads these settings on startup, so
+# at most one change is made per launch, it takes effect on the next launch and is logged;
+# telemetry also reports the latest sample. Without a pool size in Engine.ini, `minPoolSize`
+# is written, which with 1000 is what the game uses at its highest texture quality.
+memoryGovernor:
+  enable: false
+  interval: 5
+  samples: 3
+  high: 90
+  low: 75
+  step: 500
+  minPoolSize: 1000
+  maxPoolSize: 4000
+  maxMipBias: 1
+
+# If enabled every benchmark run scores the console variables in effect and writes the next
+# combination to try into Engine.ini, so it is tested on the next launch. Each parameter is
+# swept in turn while the others keep their best value so far, for up to `passes` passes over
+# all parameters. The score is the 1% low (`low1`) or average (`avg`) frame rate. List the
+# values of each parameter from the highest quality down and optionally rate each one with
+# `quality` in percent (100 if left out); combinations whose average quality is below
+# `qualityFloor` are never tried. Needs the benchmark. With its `start` and `exit` set every
+# launch runs the benchmark and closes the game on its own, so relaunching the game until
+# CodeVeinFix.tuner.yml says `done: true` finishes the search without touching F10.
+# Progress and the best settings found are kept in CodeVeinFix.tuner.yml.
+tuner:
+  enable: false
+  target: low1
+  passes: 2
+  qualityFloor: 0
+  parameters: []
+#   - cvar: r.ScreenPercentage
+#     values: [100, 90, 80]
+#     quality: [100, 90, 75]
+#   - cvar: r.Shadow.MaxResolution
+#     values: [2048, 1024]
+#     quality: [100, 80]
+
+# Debugging tools, only useful when looking for new fixes.
+debug:
+
+  # If enabled F9 takes a memory snapshot and logs what changed since the previous one.
+  # Snapshots are full copies of the game's writable memory, so make sure there is free
+  # RAM for about twice what the game uses.
+  snapshot:
+    enable: false
+
+  # If enabled the game's file reads are logged and written to CodeVeinFix.trace.csv
+  # every telemetry `interval` seconds. Past 16 MB the trace is moved to
+  # CodeVeinFix.trace.old.csv and a new one is started.
+  fileTrace:
+    enable: false
+
+  # If enabled every signature is also checked for how close it is to matching elsewhere,
+  # how common its bytes are and how much of it is needed, and a cheaper signature matching
+  # the same code is suggested. Takes up to two passes over the executable per signature.
+  signatures:
+    enable: false
+
+  # If enabled named regions, such as pattern scans and hook bodies, are timed in wall time
+  # and CPU cycles. Totals are logged after startup, with the telemetry and after a benchmark.
+  regions:
+    enable: false
+
+  # If enabled every instruction of the executable is decoded once per game build and kept
+  # in CodeVeinFix.instructions.bin, which later launches map instead of decoding again.
+  # Hook and patch sites are checked against it. The file is about 10 bytes per instruction.
+  instructions:
+    enable: false
 "@
 
 if (Test-Path -Path $gameFolder) {
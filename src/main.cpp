@@ -24,6 +24,11 @@
 
 // System includes
 #include <windows.h>
+#include <psapi.h>
+#include <d3d11.h>
+#include <dxgi.h>
+#include <dxgi1_4.h>
+#include <Xinput.h>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -32,6 +37,17 @@
 #include <numbers>
 #include <cmath>
 #include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <format>
+#include <map>
+#include <deque>
+#include <functional>
+#include <shared_mutex>
+#include <array>
 
 // 3rd party includes
 #include "spdlog/spdlog.h"
@@ -41,42 +57,425 @@
 
 // Local includes
 #include "utils.hpp"
+#include "frame_cap.hpp"
+#include "prefetch.hpp"
+#include "benchmark.hpp"
+#include "tuner.hpp"
+#include "memory_governor.hpp"
 
 // Macros
 #define LOG(STRING, ...) spdlog::info("{} : " STRING, __func__, ##__VA_ARGS__)
 
 // .yml to struct
+// Member initializers are the defaults, CodeVeinFix.yml only needs to hold overrides
 typedef struct resolution_t {
-    int width;
-    int height;
-    float aspectRatio;
+    int width = 0;
+    int height = 0;
+    float aspectRatio = 0.0f;
 } resolution_t;
 typedef struct pillarbox_t {
-    bool enable;
+    bool enable = true;
 } pillarbox_t;
 typedef struct fov_t {
-    bool enable;
-    float value;
+    bool enable = true;
+    float value = 68.0f;
 } fov_t;
 
+typedef struct background_cap_t {
+    bool enable = false;
+    int fps = 15;
+    int idle = 0;
+} background_cap_t;
+
+typedef struct fast_exit_t {
+    bool enable = false;
+    int timeout = 3000;
+} fast_exit_t;
+
 typedef struct fix_t {
     pillarbox_t pillarbox;
     fov_t fov;
+    background_cap_t backgroundCap;
+    fast_exit_t fastExit;
 } fix_t;
 
+typedef struct snapshot_t {
+    bool enable = false;
+} snapshot_t;
+
+typedef struct file_trace_t {
+    bool enable = false;
+} file_trace_t;
+
+typedef struct signatures_t {
+    bool enable = false;
+} signatures_t;
+
+typedef struct regions_t {
+    bool enable = false;
+} regions_t;
+
+typedef struct instructions_t {
+    bool enable = false;
+} instructions_t;
+
+typedef struct debug_t {
+    snapshot_t snapshot;
+    file_trace_t fileTrace;
+    regions_t regions;
+    signatures_t signatures;
+    instructions_t instructions;
+} debug_t;
+
+typedef struct telemetry_t {
+    bool enable = false;
+    int interval = 10;
+} telemetry_t;
+
+typedef struct profile_t {
+    // Keyed by resolution, or by aspect ratio alone if width and height are 0
+    int width = 0;
+    int height = 0;
+    float aspectRatio = 0.0f;
+    float fov = 68.0f;
+    // Precomputed by readYml
+    float fovCache = 0.0f;
+    std::array<uint8_t, sizeof(float)> aspectRatioBytes{};
+} profile_t;
+
+typedef struct resolution_patch_t {
+    const profile_t* profile = nullptr;
+    float aspectRatio = 0.0f;
+    float fov = 0.0f;
+    std::array<uint8_t, sizeof(float)> aspectRatioBytes{};
+} resolution_patch_t;
+
+typedef struct prefetch_t {
+    bool enable = false;
+    int budget = 512;
+} prefetch_t;
+
+typedef struct benchmark_t {
+    bool enable = false;
+    std::string label;
+    int start = 0;
+    int delay = 10;
+    int duration = 60;
+    float hitch = 2.5f;
+    bool exit = false;
+} benchmark_t;
+
+typedef struct tuner_parameter_t {
+    std::string cvar;
+    std::vector<std::string> values;
+    // Quality of each value in percent, missing ones count as 100
+    std::vector<double> quality;
+} tuner_parameter_t;
+
+typedef struct tuner_t {
+    bool enable = false;
+    std::string target = "low1";
+    int passes = 2;
+    double qualityFloor = 0.0;
+    std::vector<tuner_parameter_t> parameters;
+} tuner_t;
+
+typedef struct memory_governor_t {
+    bool enable = false;
+    int interval = 5;
+    int samples = 3;
+    int high = 90;
+    int low = 75;
+    int step = 500;
+    int minPoolSize = 1000;
+    int maxPoolSize = 4000;
+    int maxMipBias = 1;
+} memory_governor_t;
+
 typedef struct yml_t {
-    std::string name;
-    bool masterEnable;
+    std::string name = "Code Vein Fix";
+    bool masterEnable = true;
+    int threads = 0;
     resolution_t resolution;
     fix_t fix;
+    telemetry_t telemetry;
+    prefetch_t prefetch;
+    benchmark_t benchmark;
+    tuner_t tuner;
+    memory_governor_t memoryGovernor;
+    debug_t debug;
+    std::vector<profile_t> profiles;
 } yml_t;
 
+typedef struct module_section_t {
+    std::string name;
+    uintptr_t rva = 0;
+    size_t size = 0;
+    intptr_t delta = 0;
+    bool present = false;
+} module_section_t;
+
+typedef struct frame_sample_t {
+    float frameMs;
+    float presentMs;
+    // CPU cycles the game thread and the presenting render thread ran for during the frame
+    uint64_t gameCycles;
+    uint64_t renderCycles;
+} frame_sample_t;
+
+typedef struct slack_job_t {
+    const char* name;
+    std::chrono::steady_clock::time_point queued;
+    std::function<void()> job;
+} slack_job_t;
+
+typedef struct file_read_t {
+    HANDLE file;
+    uint32_t name;
+    uint64_t offset;
+    DWORD size;
+    float durationMs;
+    DWORD threadId;
+    uint64_t frame;
+} file_read_t;
+
+typedef struct traced_file_t {
+    uint32_t name = 0;
+    std::atomic<uint64_t> position = 0;
+} traced_file_t;
+
+
 // Globals
 HMODULE baseModule = GetModuleHandle(NULL);
-YAML::Node config = YAML::LoadFile("CodeVeinFix.yml");
+HMODULE dllModule = NULL;
+std::string moduleName;
+std::map<uintptr_t, std::string> symbols;
+// Relative to the DLL until resolvePaths runs
+std::string logPath = "CodeVeinFix.log";
+std::string configPath = "CodeVeinFix.yml";
+YAML::Node config;
 yml_t yml;
 
 float nativeAspectRatio = 16.0f / 9.0f;
+std::atomic<float> fovCache = 0.0f;
+// Resolution in effect, width in the high and height in the low 32 bits
+std::atomic<uint64_t> currentResolution = 0;
+std::vector<uintptr_t> aspectRatioSites;
+bool followDesktop = false;
+Utils::Event cameraReady;
+
+std::string offsetCachePath = "CodeVeinFix.cache.yml";
+const uintptr_t pageSize = 0x1000;
+YAML::Node offsetCache;
+bool offsetCacheSameBuild = false;
+std::map<std::string, YAML::Node> offsetCacheHits;
+// Hash of every page of the executable this launch, taken before any fix patches it
+std::vector<uint64_t> offsetCachePages;
+// Sections of the cached build, with how far each moved in this build
+std::vector<module_section_t> offsetCacheSections;
+// Pages of this build whose bytes differ from the cached build, and their runs as RVA ranges
+std::vector<bool> offsetCacheChangedPages;
+std::vector<std::pair<uintptr_t, uintptr_t>> offsetCacheChangedRuns;
+
+std::string instructionTablePath = "CodeVeinFix.instructions.bin";
+Utils::InstructionTable instructionTable;
+
+SafetyHookInline presentHook{};
+std::atomic<uint64_t> frameCount = 0;
+Utils::RingBuffer<frame_sample_t, 8192> telemetryRing;
+std::atomic<bool> telemetryReportPending = false;
+HWND gameWindow = NULL;
+// GetTickCount of the latest gamepad input, keyboard and mouse come from GetLastInputInfo
+std::atomic<DWORD> lastGamepadInput = GetTickCount();
+std::atomic<bool> gamepadPollPending = false;
+
+const float slackMinMs = 1.0f;
+const auto slackMaxDefer = std::chrono::seconds(2);
+std::mutex slackMutex;
+std::deque<slack_job_t> slackJobs;
+std::map<std::string, float> slackEstimates;
+std::atomic<size_t> slackQueued = 0;
+std::atomic<bool> frameUnderLoad = false;
+std::atomic<uint64_t> slackDispatched = 0;
+std::atomic<uint64_t> slackForced = 0;
+std::atomic<uint64_t> slackDeferredFrames = 0;
+std::atomic<uint64_t> slackBudgetUs = 0;
+std::atomic<uint64_t> slackFrames = 0;
+
+std::string benchmarkPath = "CodeVeinFix.benchmark.csv";
+std::atomic<bool> benchmarkTriggered = false;
+std::atomic<bool> benchmarkRegionsReset = false;
+std::vector<frame_sample_t> benchmarkSamples;
+
+std::string tunerPath = "CodeVeinFix.tuner.yml";
+Utils::tuner_state_t tunerState;
+std::mutex engineIniMutex;
+
+std::atomic<IDXGIAdapter3*> gameAdapter = nullptr;
+std::atomic<int> memoryPoolSize = 0;
+std::atomic<int> memoryMipBias = 0;
+std::atomic<uint64_t> memoryVideoMb = 0;
+std::atomic<uint64_t> memoryVideoBudgetMb = 0;
+std::atomic<uint64_t> memorySharedVideoMb = 0;
+std::atomic<bool> memoryAdjusted = false;
+std::atomic<uint64_t> memoryCommitMb = 0;
+std::atomic<uint64_t> memoryWorkingSetMb = 0;
+std::atomic<int> memoryLoad = 0;
+std::atomic<int> memoryAdjustments = 0;
+std::atomic<bool> memoryGovernorPending = false;
+
+DWORD gameThreadId = 0;
+HANDLE gameThread = NULL;
+std::atomic<HANDLE> renderThread = NULL;
+std::string fileTracePath = "CodeVeinFix.trace.csv";
+decltype(&CreateFileW) originalCreateFileW = nullptr;
+decltype(&ReadFile) originalReadFile = nullptr;
+decltype(&SetFilePointer) originalSetFilePointer = nullptr;
+decltype(&SetFilePointerEx) originalSetFilePointerEx = nullptr;
+decltype(&CloseHandle) originalCloseHandle = nullptr;
+const uint32_t fileTraceUnnamed = UINT32_MAX;
+const uintmax_t fileTraceMaxSize = 16 * 1024 * 1024;
+std::mutex fileTraceMutex;
+std::vector<std::wstring> fileTraceNames;
+std::map<std::wstring, uint32_t> fileTraceNameIds;
+std::shared_mutex fileTraceHandlesMutex;
+std::map<HANDLE, traced_file_t> fileTraceHandles;
+std::vector<Utils::RingBuffer<file_read_t, 1024>*> fileTraceRings;
+std::atomic<bool> fileTraceReportPending = false;
+
+decltype(&PostQuitMessage) originalPostQuitMessage = nullptr;
+decltype(&WriteFile) originalWriteFile = nullptr;
+std::atomic<int> pendingWrites = 0;
+std::atomic<std::chrono::steady_clock::rep> lastWriteTime = 0;
+std::mutex overlappedWritesMutex;
+std::vector<LPOVERLAPPED> overlappedWrites;
+
+std::mutex prefetchMutex;
+std::map<std::string, std::vector<Utils::file_range_t>> prefetchedRanges;
+// Frames after startup, or after a traced read, whose ranges are prefetched
+const uint64_t prefetchLookahead = 3600;
+std::atomic<bool> prefetchFollowing = false;
+std::mutex prefetchReadsMutex;
+// Reads of the game the prefetcher has yet to follow, as interned name and offset
+std::vector<std::pair<uint32_t, uint64_t>> prefetchReads;
+
+/**
+ * @brief Publishes the resolution in effect.
+ *
+ * @details
+ * `yml.resolution` holds the resolution the game started with and is never written after
+ * `readYml`. Display changes arrive on the listener thread while the thread pool reads the
+ * resolution, so both halves are published together in one atomic word.
+ *
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @return void
+ */
+void setResolution(int width, int height) {
+    currentResolution.store(((uint64_t)(uint32_t)width << 32) | (uint32_t)height);
+}
+
+/**
+ * @brief Returns a consistent snapshot of the resolution in effect.
+ *
+ * @return resolution_t
+ */
+resolution_t getResolution() {
+    uint64_t packed = currentResolution.load();
+    resolution_t resolution;
+    resolution.width = (int)(packed >> 32);
+    resolution.height = (int)(uint32_t)packed;
+    resolution.aspectRatio = resolution.height ? (float)resolution.width / (float)resolution.height : 0.0f;
+    return resolution;
+}
+
+/**
+ * @brief Computes the horizontal FOV scaled from 16:9 to an aspect ratio.
+ *
+ * @details
+ * The FOV accessor hooked by `fovFix` is called several times per frame, so the
+ * trigonometry is done once up front and the hook only loads the cached result.
+ * Recompute whenever the FOV value or the aspect ratio changes.
+ *
+ * @param fov FOV in degrees at 16:9.
+ * @param aspectRatio Target aspect ratio.
+ * @return float Scaled FOV in degrees.
+ */
+float computeFov(float fov, float aspectRatio) {
+    float pi = std::numbers::pi_v<float>;
+    return atanf(tanf(fov * pi / 360.0f) / nativeAspectRatio * aspectRatio) * 360.0f / pi;
+}
+
+/**
+ * @brief Finds the configured profile for a resolution.
+ *
+ * @details
+ * A profile for the exact resolution wins. Otherwise the first profile keyed by aspect
+ * ratio alone that is within 0.5% of the resolution's aspect ratio is used, so e.g. one
+ * 21:9 profile can serve several resolutions.
+ *
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @return const profile_t* Matching profile, nullptr if there is none.
+ */
+const profile_t* findProfile(int width, int height) {
+    for (const auto& profile : yml.profiles) {
+        if (profile.width == width && profile.height == height) {
+            return &profile;
+        }
+    }
+    float aspectRatio = (float)width / (float)height;
+    for (const auto& profile : yml.profiles) {
+        if (profile.width == 0 && std::abs(profile.aspectRatio - aspectRatio) <= profile.aspectRatio * 0.005f) {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Resolves the aspect ratio and FOV to apply at a resolution.
+ *
+ * @details
+ * A matching profile's precomputed values are used as they are, otherwise they are
+ * computed from the resolution and the configured FOV.
+ *
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @return resolution_patch_t
+ */
+resolution_patch_t resolvePatch(int width, int height) {
+    const profile_t* profile = findProfile(width, height);
+    if (profile) {
+        return { profile, profile->aspectRatio, profile->fovCache, profile->aspectRatioBytes };
+    }
+    resolution_patch_t patch;
+    patch.aspectRatio = (float)width / (float)height;
+    patch.fov = computeFov(yml.fix.fov.value, patch.aspectRatio);
+    memcpy(patch.aspectRatioBytes.data(), &patch.aspectRatio, sizeof(patch.aspectRatio));
+    return patch;
+}
+
+/**
+ * @brief Parses an aspect ratio given as a ratio, e.g. "43:18", or as a number.
+ *
+ * @param text Aspect ratio from the config.
+ * @return float Aspect ratio, 0 if it does not parse.
+ */
+float parseAspectRatio(const std::string& text) {
+    try {
+        size_t colon = text.find(':');
+        if (colon == std::string::npos) {
+            return std::stof(text);
+        }
+        float width = std::stof(text.substr(0, colon));
+        float height = std::stof(text.substr(colon + 1));
+        return height > 0.0f ? width / height : 0.0f;
+    }
+    catch (const std::exception&) {
+        return 0.0f;
+    }
+}
 
 /**
  * @brief Initializes logging for the application.
@@ -86,11 +485,15 @@ float nativeAspectRatio = 16.0f / 9.0f;
  * 2. Retrieves and logs the path and name of the executable module.
  * 3. Logs detailed information about the module to aid in debugging.
  *
+ * @details
+ * Every message is written and flushed before `LOG` returns, so the last lines before a
+ * crash are in the file.
+ *
  * @return void
  */
 void logInit() {
     // spdlog initialisation
-    auto logger = spdlog::basic_logger_mt("CodeVein", "CodeVeinFix.log");
+    auto logger = spdlog::basic_logger_mt("CodeVein", logPath);
     spdlog::set_default_logger(logger);
     spdlog::flush_on(spdlog::level::debug);
 
@@ -99,6 +502,7 @@ void logInit() {
     GetModuleFileNameW(baseModule, exePath, MAX_PATH);
     std::filesystem::path exeFilePath = exePath;
     std::string exeName = exeFilePath.filename().string();
+    moduleName = exeName;
 
     // Log module details
     LOG("-------------------------------------");
@@ -108,190 +512,943 @@ void logInit() {
     LOG("Module Addr: 0x{:x}", (uintptr_t)baseModule);
 }
 
+/**
+ * @brief Places the mod's files next to the DLL.
+ *
+ * @details
+ * The config, log, caches and reports used to be opened relative to the current directory,
+ * which is only the DLL's directory as long as the loader leaves it there. Anchoring them to
+ * the directory `GetModuleFileNameW` reports for the DLL keeps them found whatever the
+ * current directory is. Must run before anything opens one of them, the log included.
+ *
+ * @return void
+ */
+void resolvePaths() {
+    WCHAR dllPath[_MAX_PATH] = { 0 };
+    if (!dllModule || GetModuleFileNameW(dllModule, dllPath, MAX_PATH) == 0) {
+        return;
+    }
+    std::filesystem::path directory = std::filesystem::path(dllPath).parent_path();
+    for (std::string* path : { &logPath, &configPath, &offsetCachePath, &instructionTablePath, &benchmarkPath, &tunerPath, &fileTracePath }) {
+        *path = (directory / *path).string();
+    }
+}
+
+/**
+ * @brief Overrides a setting with its value from the configuration file, if present.
+ *
+ * @details
+ * Walks `root` along `path` without modifying it. If any key along the way is missing,
+ * or the value cannot be converted to `T`, `value` keeps its compiled in default and the
+ * key is logged.
+ *
+ * @param root Node to start from, usually `config`.
+ * @param path Keys leading to the setting, e.g. {"fixes", "fov", "value"}.
+ * @param value Setting to override.
+ * @return void
+ */
+template <typename T>
+void readKey(const YAML::Node& root, std::initializer_list<const char*> path, T& value) {
+    std::string name;
+    for (const char* key : path) {
+        name += name.empty() ? key : std::string(".") + key;
+    }
+    YAML::Node node;
+    node.reset(root);
+    for (const char* key : path) {
+        if (!node.IsMap()) {
+            LOG("'{}' not set, using default", name);
+            return;
+        }
+        const YAML::Node& parent = node;
+        YAML::Node child = parent[key];
+        if (!child.IsDefined()) {
+            LOG("'{}' not set, using default", name);
+            return;
+        }
+        node.reset(child);
+    }
+    try {
+        value = node.as<T>();
+    }
+    catch (const YAML::Exception& e) {
+        LOG("Ignoring invalid value for '{}', using default: {}", name, e.what());
+    }
+}
+
 /**
  * @brief Reads and parses configuration settings from a YAML file.
  *
  * This function performs the following tasks:
- * 1. Reads general settings from the configuration file and assigns them to the `yml` structure.
- * 2. Initializes global settings if certain values are missing or default.
- * 3. Logs the parsed configuration values for debugging purposes.
+ * 1. Loads the configuration file, if there is one.
+ * 2. Overrides the compiled in defaults of the `yml` structure with the values it contains.
+ * 3. Initializes global settings if certain values are missing or default.
+ * 4. Logs the parsed configuration values for debugging purposes.
+ *
+ * @details
+ * Every setting has a default in the `yml` structure, so the file only needs the keys the
+ * user wants to change. A missing file, a missing key or an unparsable file all fall back to
+ * the defaults instead of throwing; without a file nothing is read from disk at all.
  *
  * @return void
  */
 void readYml() {
-    yml.name = config["name"].as<std::string>();
+    if (std::filesystem::exists(configPath)) {
+        try {
+            config = YAML::LoadFile(configPath);
+        }
+        catch (const YAML::Exception& e) {
+            LOG("Failed to load '{}', using defaults: {}", configPath, e.what());
+        }
+    }
+    else {
+        LOG("'{}' not found, using defaults", configPath);
+    }
+
+    readKey(config, {"name"}, yml.name);
+
+    readKey(config, {"masterEnable"}, yml.masterEnable);
+
+    readKey(config, {"threads"}, yml.threads);
+
+    readKey(config, {"resolution", "width"}, yml.resolution.width);
+    readKey(config, {"resolution", "height"}, yml.resolution.height);
+
+    readKey(config, {"fixes", "pillarbox", "enable"}, yml.fix.pillarbox.enable);
 
-    yml.masterEnable = config["masterEnable"].as<bool>();
+    readKey(config, {"fixes", "fov", "enable"}, yml.fix.fov.enable);
+    readKey(config, {"fixes", "fov", "value"}, yml.fix.fov.value);
 
-    yml.resolution.width = config["resolution"]["width"].as<int>();
-    yml.resolution.height = config["resolution"]["height"].as<int>();
+    readKey(config, {"fixes", "backgroundCap", "enable"}, yml.fix.backgroundCap.enable);
+    readKey(config, {"fixes", "backgroundCap", "fps"}, yml.fix.backgroundCap.fps);
+    readKey(config, {"fixes", "backgroundCap", "idle"}, yml.fix.backgroundCap.idle);
+    yml.fix.backgroundCap.fps = std::max(1, yml.fix.backgroundCap.fps);
+    yml.fix.backgroundCap.idle = std::max(0, yml.fix.backgroundCap.idle);
 
-    yml.fix.pillarbox.enable = config["fixes"]["pillarbox"]["enable"].as<bool>();
+    readKey(config, {"fixes", "fastExit", "enable"}, yml.fix.fastExit.enable);
+    readKey(config, {"fixes", "fastExit", "timeout"}, yml.fix.fastExit.timeout);
 
-    yml.fix.fov.enable = config["fixes"]["fov"]["enable"].as<bool>();
-    yml.fix.fov.value = config["fixes"]["fov"]["value"].as<float>();
+    readKey(config, {"telemetry", "enable"}, yml.telemetry.enable);
+    readKey(config, {"telemetry", "interval"}, yml.telemetry.interval);
+
+    readKey(config, {"prefetch", "enable"}, yml.prefetch.enable);
+    readKey(config, {"prefetch", "budget"}, yml.prefetch.budget);
+
+    readKey(config, {"benchmark", "enable"}, yml.benchmark.enable);
+    readKey(config, {"benchmark", "label"}, yml.benchmark.label);
+    readKey(config, {"benchmark", "start"}, yml.benchmark.start);
+    readKey(config, {"benchmark", "delay"}, yml.benchmark.delay);
+    readKey(config, {"benchmark", "duration"}, yml.benchmark.duration);
+    readKey(config, {"benchmark", "hitch"}, yml.benchmark.hitch);
+    readKey(config, {"benchmark", "exit"}, yml.benchmark.exit);
+    yml.benchmark.duration = std::max(1, yml.benchmark.duration);
+
+    readKey(config, {"tuner", "enable"}, yml.tuner.enable);
+    readKey(config, {"tuner", "target"}, yml.tuner.target);
+    readKey(config, {"tuner", "passes"}, yml.tuner.passes);
+    readKey(config, {"tuner", "qualityFloor"}, yml.tuner.qualityFloor);
+    yml.tuner.passes = std::max(1, yml.tuner.passes);
+
+    readKey(config, {"debug", "snapshot", "enable"}, yml.debug.snapshot.enable);
+    readKey(config, {"debug", "fileTrace", "enable"}, yml.debug.fileTrace.enable);
+    readKey(config, {"debug", "regions", "enable"}, yml.debug.regions.enable);
+    readKey(config, {"debug", "signatures", "enable"}, yml.debug.signatures.enable);
+    readKey(config, {"debug", "instructions", "enable"}, yml.debug.instructions.enable);
+
+    readKey(config, {"memoryGovernor", "enable"}, yml.memoryGovernor.enable);
+    readKey(config, {"memoryGovernor", "interval"}, yml.memoryGovernor.interval);
+    readKey(config, {"memoryGovernor", "samples"}, yml.memoryGovernor.samples);
+    readKey(config, {"memoryGovernor", "high"}, yml.memoryGovernor.high);
+    readKey(config, {"memoryGovernor", "low"}, yml.memoryGovernor.low);
+    readKey(config, {"memoryGovernor", "step"}, yml.memoryGovernor.step);
+    readKey(config, {"memoryGovernor", "minPoolSize"}, yml.memoryGovernor.minPoolSize);
+    readKey(config, {"memoryGovernor", "maxPoolSize"}, yml.memoryGovernor.maxPoolSize);
+    readKey(config, {"memoryGovernor", "maxMipBias"}, yml.memoryGovernor.maxMipBias);
+    yml.memoryGovernor.interval = std::max(1, yml.memoryGovernor.interval);
+    yml.memoryGovernor.samples = std::max(1, yml.memoryGovernor.samples);
+    yml.memoryGovernor.low = std::min(yml.memoryGovernor.low, yml.memoryGovernor.high);
+    yml.memoryGovernor.maxPoolSize = std::max(yml.memoryGovernor.minPoolSize, yml.memoryGovernor.maxPoolSize);
+    yml.memoryGovernor.maxMipBias = std::max(0, yml.memoryGovernor.maxMipBias);
+
+    const YAML::Node& root = config;
+    if (root["tuner"] && root["tuner"]["parameters"] && root["tuner"]["parameters"].IsSequence()) {
+        for (const auto& node : root["tuner"]["parameters"]) {
+            tuner_parameter_t parameter;
+            readKey(node, {"cvar"}, parameter.cvar);
+            readKey(node, {"values"}, parameter.values);
+            readKey(node, {"quality"}, parameter.quality);
+            if (!parameter.cvar.empty() && !parameter.values.empty()) {
+                yml.tuner.parameters.push_back(parameter);
+            }
+        }
+    }
+    if (root["profiles"] && root["profiles"].IsSequence()) {
+        for (const auto& node : root["profiles"]) {
+            profile_t profile;
+            std::string aspectRatio;
+            readKey(node, {"width"}, profile.width);
+            readKey(node, {"height"}, profile.height);
+            readKey(node, {"aspectRatio"}, aspectRatio);
+            readKey(node, {"fov"}, profile.fov);
+            if (profile.width > 0 && profile.height > 0) {
+                profile.aspectRatio = (float)profile.width / (float)profile.height;
+                yml.profiles.push_back(profile);
+            }
+            else if ((profile.aspectRatio = parseAspectRatio(aspectRatio)) > 0.0f) {
+                profile.width = 0;
+                profile.height = 0;
+                yml.profiles.push_back(profile);
+            }
+        }
+    }
 
     // Initialize globals
+    Utils::setWorkerLimit(yml.threads);
+    Utils::enableRegions(yml.debug.regions.enable);
     if (yml.resolution.width == 0 || yml.resolution.height == 0) {
+        followDesktop = true;
         std::pair<int, int> dimensions = Utils::GetDesktopDimensions();
         yml.resolution.width  = dimensions.first;
         yml.resolution.height = dimensions.second;
     }
     yml.resolution.aspectRatio = (float)yml.resolution.width / (float)yml.resolution.height;
+    setResolution(yml.resolution.width, yml.resolution.height);
+    for (auto& profile : yml.profiles) {
+        profile.fovCache = computeFov(profile.fov, profile.aspectRatio);
+        memcpy(profile.aspectRatioBytes.data(), &profile.aspectRatio, sizeof(profile.aspectRatio));
+    }
 
     LOG("Name: {}", yml.name);
     LOG("MasterEnable: {}", yml.masterEnable);
+    LOG("Threads: {}", yml.threads);
     LOG("Resolution.Width: {}", yml.resolution.width);
     LOG("Resolution.Height: {}", yml.resolution.height);
     LOG("Resolution.AspectRatio: {}", yml.resolution.aspectRatio);
     LOG("Fix.Pillarbox.Enable: {}", yml.fix.pillarbox.enable);
     LOG("Fix.Fov.Enable: {}", yml.fix.fov.enable);
     LOG("Fix.Fov.Value: {}", yml.fix.fov.value);
+    LOG("Fix.BackgroundCap.Enable: {}", yml.fix.backgroundCap.enable);
+    LOG("Fix.BackgroundCap.Fps: {}", yml.fix.backgroundCap.fps);
+    LOG("Fix.BackgroundCap.Idle: {}", yml.fix.backgroundCap.idle);
+    LOG("Fix.FastExit.Enable: {}", yml.fix.fastExit.enable);
+    LOG("Fix.FastExit.Timeout: {}", yml.fix.fastExit.timeout);
+    LOG("Telemetry.Enable: {}", yml.telemetry.enable);
+    LOG("Telemetry.Interval: {}", yml.telemetry.interval);
+    LOG("Prefetch.Enable: {}", yml.prefetch.enable);
+    LOG("Prefetch.Budget: {}", yml.prefetch.budget);
+    LOG("Benchmark.Enable: {}", yml.benchmark.enable);
+    LOG("Benchmark.Label: {}", yml.benchmark.label);
+    LOG("Benchmark.Start: {}", yml.benchmark.start);
+    LOG("Benchmark.Delay: {}", yml.benchmark.delay);
+    LOG("Benchmark.Duration: {}", yml.benchmark.duration);
+    LOG("Benchmark.Hitch: {}", yml.benchmark.hitch);
+    LOG("Benchmark.Exit: {}", yml.benchmark.exit);
+    LOG("Tuner.Enable: {}", yml.tuner.enable);
+    LOG("Tuner.Target: {}", yml.tuner.target);
+    LOG("Tuner.Passes: {}", yml.tuner.passes);
+    LOG("Tuner.QualityFloor: {}", yml.tuner.qualityFloor);
+    for (const auto& parameter : yml.tuner.parameters) {
+        LOG("Tuner.Parameter: {}, {} value(s), {} quality value(s)", parameter.cvar, parameter.values.size(), parameter.quality.size());
+    }
+    LOG("MemoryGovernor.Enable: {}", yml.memoryGovernor.enable);
+    LOG("MemoryGovernor.Interval: {}", yml.memoryGovernor.interval);
+    LOG("MemoryGovernor.Samples: {}", yml.memoryGovernor.samples);
+    LOG("MemoryGovernor.High: {}", yml.memoryGovernor.high);
+    LOG("MemoryGovernor.Low: {}", yml.memoryGovernor.low);
+    LOG("MemoryGovernor.Step: {}", yml.memoryGovernor.step);
+    LOG("MemoryGovernor.MinPoolSize: {}", yml.memoryGovernor.minPoolSize);
+    LOG("MemoryGovernor.MaxPoolSize: {}", yml.memoryGovernor.maxPoolSize);
+    LOG("MemoryGovernor.MaxMipBias: {}", yml.memoryGovernor.maxMipBias);
+    LOG("Debug.Snapshot.Enable: {}", yml.debug.snapshot.enable);
+    LOG("Debug.FileTrace.Enable: {}", yml.debug.fileTrace.enable);
+    LOG("Debug.Regions.Enable: {}", yml.debug.regions.enable);
+    LOG("Debug.Signatures.Enable: {}", yml.debug.signatures.enable);
+    LOG("Debug.Instructions.Enable: {}", yml.debug.instructions.enable);
+    for (const auto& profile : yml.profiles) {
+        LOG("Profile: {}x{}, AspectRatio {} '{}', Fov {}, FovCache {}",
+            profile.width, profile.height, profile.aspectRatio,
+            Utils::bytesToString((void*)profile.aspectRatioBytes.data(), profile.aspectRatioBytes.size()),
+            profile.fov, profile.fovCache
+        );
+    }
 }
 
 /**
- * @brief Applies a pillar box fix by patching a specific memory pattern.
- *
- * This function performs the following tasks:
- * 1. Checks if the pillar box fix is enabled based on the configuration.
- * 2. Searches for a specific memory pattern in the base module.
- * 3. Patches the found pattern with a new value to correct the pillar box issue.
+ * @brief Identifies the build of the executable for the offset cache.
  *
  * @details
- * The function first checks if the pillar box fix is enabled according to the configuration. It
- * then searches for a predefined byte sequence in the memory of the base module. When the pattern
- * is found, it patches the memory with a new byte sequence to address the pillar box issue.
+ * The fingerprint is taken once, on the first call, before any fix has patched the module.
  *
- * The pattern to find and the pattern to use for patching are hardcoded as byte sequences.
+ * @return uint64_t Fingerprint of the base module from `Utils::fingerprintModule`.
+ */
+uint64_t getBuildId() {
+    static uint64_t buildId = [] {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t fingerprint = Utils::fingerprintModule(baseModule);
+        auto end = std::chrono::steady_clock::now();
+        LOG("Fingerprinted module in {} us",
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+        );
+        return fingerprint;
+    }();
+    return buildId;
+}
+
+/**
+ * @brief Counts the bytes in an IDA-style byte array pattern.
  *
- * How was this found?
- * No idea, will update this later.
- * 
- * @return void
+ * @param pattern IDA-style byte array pattern.
+ * @return size_t Number of bytes, wildcards included.
  */
-void pillarBoxFix() {
-    const char* patternFind  = "F6 41 2C 01 4C";
-    const char* patternPatch = "F6 41 2C 00";
+size_t patternLength(const char* pattern) {
+    std::istringstream stream(pattern);
+    return std::distance(
+        std::istream_iterator<std::string>(stream), std::istream_iterator<std::string>()
+    );
+}
 
-    bool enable = yml.masterEnable & yml.fix.pillarbox.enable;
-    LOG("Fix {}", enable ? "Enabled" : "Disabled");
-    if (enable) {
-        std::vector<uint64_t> addr;
-        Utils::patternScan(baseModule, patternFind, &addr);
-        uint8_t* hit = (uint8_t*)addr[0];
-        uintptr_t absAddr = (uintptr_t)hit;
-        uintptr_t relAddr = (uintptr_t)hit - (uintptr_t)baseModule;
-        if (hit) {
-            LOG("Found '{}' @ 0x{:x}", patternFind, relAddr);
-            Utils::patch(absAddr, patternPatch);
-            LOG("Patched '{}' with '{}'", patternFind, patternPatch);
-        }
-        else {
-            LOG("Did not find '{}'", patternFind);
-        }
+/**
+ * @brief Lists the sections of the executable.
+ *
+ * @return std::vector<module_section_t> Name, RVA and size of every section.
+ */
+std::vector<module_section_t> getSections() {
+    auto dosHeader = (PIMAGE_DOS_HEADER)baseModule;
+    auto ntHeaders = (PIMAGE_NT_HEADERS)((uint8_t*)baseModule + dosHeader->e_lfanew);
+    auto section = IMAGE_FIRST_SECTION(ntHeaders);
+    std::vector<module_section_t> sections;
+    for (WORD i = 0; i < ntHeaders->FileHeader.NumberOfSections; i++, section++) {
+        sections.push_back({
+            std::string((const char*)section->Name, strnlen((const char*)section->Name, IMAGE_SIZEOF_SHORT_NAME)),
+            section->VirtualAddress,
+            section->Misc.VirtualSize
+        });
     }
+    return sections;
 }
 
 /**
- * @brief Applies a resolution fix by patching a specific memory pattern.
- *
- * This function performs the following tasks:
- * 1. Logs the current desktop resolution and aspect ratio.
- * 2. Determines the pattern to use for patching based on the aspect ratio.
- * 3. Searches for a specific memory pattern in the base module.
- * 4. Patches the found patterns with the calculated aspect ratio.
+ * @brief Finds the pages that changed since the cached build.
  *
  * @details
- * The function first logs the desktop resolution and aspect ratio for debugging purposes.
- * It then converts the aspect ratio to a byte pattern for use in memory patching.
- * The function performs a pattern scan to find occurrences of a predefined byte sequence in the
- * memory of the base module. For each occurrence found, it applies a patch using the calculated
- * aspect ratio.
- *
- * The patching is only performed if the fix is enabled according to the configuration.
+ * A game update often moves whole sections when one before them grows. Every section of the
+ * cached build is matched by name, in order, with a section of this build, and each page of
+ * this build is compared with the cached page at the same offset into its section. Pages
+ * outside any section, the headers, are compared at the same RVA. A page is also treated as
+ * changed when it starts a section that moved by a different amount than the one before it,
+ * since a hit spanning the two was not contiguous in the cached build.
  *
- * How was this found?
- * All Unreal Engine 4 games store the aspect ratio, a variable amount of times throughout the
- * executable. It is always hard coded to 16:9 and in order to get the game to render on
- * ultrawide+ resolutions, it is necessary to patch the aspect ratio to your target ratio,
- * usually 21:9 or 32:9.
- * 
- * So every location that has 16:9 (39 8E E3 3F) will be patched with target aspect ratio
- * hex pattern, for 21:9: 8E E3 18 40 (typically), for 32:9: 39 8E 63 40.
- * 
- * This game has two instances of the 16:9 pattern in the executable, so both will be patched.
- * 1. CodeVein-Win64-Shipping.exe+6A63D3D
- * 2. CodeVein-Win64-Shipping.exe+6A64786
- * 
+ * @param cachedPages Page hashes of the cached build.
  * @return void
  */
-void resolutionFix() {
-    const char* patternFind  = "39 8E E3 3F";
-    const char* patternPatch;
-
-    LOG("Desktop resolution: {}x{}",
-        yml.resolution.width, yml.resolution.height
-    );
-    LOG("Aspect Ratio: {}:{} {}",
-        yml.resolution.width / std::gcd(yml.resolution.width, yml.resolution.height),
-        yml.resolution.height / std::gcd(yml.resolution.width, yml.resolution.height),
-        yml.resolution.aspectRatio
-    );
-
-    // Use acquired desktop resolution to resolve the pattern that will be used to patch
-    std::string patternPatchString = Utils::bytesToString(
-        (void*)&yml.resolution.aspectRatio,
-        sizeof(yml.resolution.aspectRatio)
-    );
-    patternPatch = patternPatchString.c_str();
+void diffCachedPages(const std::vector<uint64_t>& cachedPages) {
+    std::vector<module_section_t> sections = getSections();
+    std::vector<bool> matched(sections.size(), false);
+    for (auto& cached : offsetCacheSections) {
+        for (size_t i = 0; i < sections.size(); i++) {
+            if (!matched[i] && sections[i].name == cached.name) {
+                matched[i] = true;
+                cached.present = true;
+                cached.delta = (intptr_t)sections[i].rva - (intptr_t)cached.rva;
+                break;
+            }
+        }
+    }
 
-    bool enable = yml.masterEnable & yml.fix.pillarbox.enable;
-    LOG("Fix {}", enable ? "Enabled" : "Disabled");
-    if (enable) {
-        std::vector<uint64_t> addr;
-        Utils::patternScan(baseModule, patternFind, &addr);
-        for (size_t i = 0; i < addr.size(); i++) {
-            uint8_t* hit = (uint8_t*)addr[i];
-            uintptr_t absAddr = (uintptr_t)hit;
-            uintptr_t relAddr = (uintptr_t)hit - (uintptr_t)baseModule;
-            if (hit) {
-                LOG("Found '{}' @ 0x{:x}",
-                    patternFind, relAddr
-                );
-                Utils::patch(absAddr, patternPatch);
-                LOG("Patched '{}' with '{}'",
-                    patternFind, patternPatch
+    offsetCacheChangedPages.assign(offsetCachePages.size(), true);
+    for (size_t page = 0; page < offsetCachePages.size(); page++) {
+        uintptr_t rva = page * pageSize;
+        intptr_t delta = 0;
+        for (size_t i = 0; i < sections.size(); i++) {
+            if (rva >= sections[i].rva && rva < sections[i].rva + sections[i].size) {
+                auto cached = std::find_if(offsetCacheSections.begin(), offsetCacheSections.end(),
+                    [&](const module_section_t& section) { return section.present && section.name == sections[i].name; }
                 );
+                if (cached == offsetCacheSections.end() || rva - cached->delta >= cached->rva + cached->size) {
+                    delta = INTPTR_MAX;
+                }
+                else {
+                    delta = cached->delta;
+                }
+                break;
             }
-            else {
-                LOG("Did not find '{}'", patternFind);
+        }
+        if (delta == INTPTR_MAX) {
+            continue;
+        }
+        size_t cachedPage = (rva - delta) / pageSize;
+        offsetCacheChangedPages[page] = cachedPage >= cachedPages.size() || cachedPages[cachedPage] != offsetCachePages[page];
+    }
+    for (size_t i = 1; i < offsetCacheSections.size(); i++) {
+        const auto& section = offsetCacheSections[i];
+        if (section.present && section.delta != offsetCacheSections[i - 1].delta) {
+            size_t page = (section.rva + section.delta) / pageSize;
+            if (page < offsetCacheChangedPages.size()) {
+                offsetCacheChangedPages[page] = true;
             }
         }
     }
+
+    offsetCacheChangedRuns.clear();
+    for (size_t page = 0; page < offsetCacheChangedPages.size(); page++) {
+        if (!offsetCacheChangedPages[page]) {
+            continue;
+        }
+        if (!offsetCacheChangedRuns.empty() && offsetCacheChangedRuns.back().second == page * pageSize) {
+            offsetCacheChangedRuns.back().second += pageSize;
+        }
+        else {
+            offsetCacheChangedRuns.push_back({ page * pageSize, (page + 1) * pageSize });
+        }
+    }
 }
 
 /**
- * @brief Applies a field of view (FOV) fix by hooking a specific pattern in memory.
- *
- * This function performs the following tasks:
- * 1. Checks if the FOV fix is enabled based on the configuration.
- * 2. Searches for a specific memory pattern in the base module.
- * 3. Hooks the identified pattern to modify the FOV value.
+ * @brief Loads the offset cache written by a previous launch.
  *
  * @details
- * The function uses a pattern scan to find a specific byte sequence in the memory of the base module.
- * If the pattern is found, a hook is created at an offset from the found pattern address. The hook
- * modifies the FOV value by adjusting it according to the aspect ratio and multiplier specified in
- * the configuration.
+ * The cache stores the RVA of every hit per signature, the sections and a hash of every page
+ * of the build it was recorded for. A missing or corrupt cache just means every signature
+ * gets scanned. On a new build the executable's pages are hashed here, before any fix patches
+ * them, and compared with the cached ones, see `diffCachedPages`.
  *
- * The hook function calculates the new FOV value using trigonometric functions based on the current
- * aspect ratio and the configuration multiplier, then applies this new value to the appropriate register.
- *
- * How was this found?
- * With Universal Unreal Engine 4 Unlocker (UUU), through experimentation 68.0 is the default FOV value.
- * Using cheat engine the FOV value was tracked down to be at 0x4E87_756C and only one instruction
- * accesses this memory address: F3 0F10 81 9C030000 - movss xmm0,[rcx+0000039C].
- * Although that is only the instruction that interacts with the FOV value, there are more instructions
+ * @return void
+ */
+void loadOffsetCache() {
+    if (std::filesystem::exists(offsetCachePath)) {
+        try {
+            offsetCache = YAML::LoadFile(offsetCachePath);
+        }
+        catch (const YAML::Exception& e) {
+            LOG("Failed to load '{}': {}", offsetCachePath, e.what());
+            offsetCache = YAML::Node();
+        }
+    }
+    uint64_t buildId = getBuildId();
+    std::vector<uint64_t> cachedPages;
+    try {
+        offsetCacheSameBuild = offsetCache["build"] && offsetCache["build"].as<uint64_t>() == buildId;
+        if (offsetCache["pages"]) {
+            YAML::Binary pages = offsetCache["pages"].as<YAML::Binary>();
+            cachedPages.resize(pages.size() / sizeof(uint64_t));
+            memcpy(cachedPages.data(), pages.data(), cachedPages.size() * sizeof(uint64_t));
+        }
+        for (const auto& section : offsetCache["sections"]) {
+            offsetCacheSections.push_back({
+                section["name"].as<std::string>(), section["rva"].as<uintptr_t>(), section["size"].as<size_t>()
+            });
+        }
+    }
+    catch (const YAML::Exception& e) {
+        LOG("Ignoring corrupt '{}': {}", offsetCachePath, e.what());
+        offsetCache = YAML::Node();
+        offsetCacheSameBuild = false;
+        cachedPages.clear();
+        offsetCacheSections.clear();
+    }
+    LOG("Build: 0x{:x}, cache {}", buildId,
+        !offsetCache["build"] ? "empty" : offsetCacheSameBuild ? "current" : "from another build"
+    );
+
+    auto start = std::chrono::steady_clock::now();
+    if (offsetCacheSameBuild && !cachedPages.empty()) {
+        offsetCachePages = std::move(cachedPages);
+        return;
+    }
+    offsetCachePages = Utils::hashPages(baseModule);
+    if (!offsetCacheSameBuild && !cachedPages.empty()) {
+        diffCachedPages(cachedPages);
+        size_t changed = std::count(offsetCacheChangedPages.begin(), offsetCacheChangedPages.end(), true);
+        LOG("{} of {} page(s) changed since the cached build", changed, offsetCachePages.size());
+        // Rescanning most of the module page run by page run is no cheaper than a full scan
+        if (changed * 2 > offsetCachePages.size()) {
+            offsetCacheChangedPages.clear();
+            offsetCacheChangedRuns.clear();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    LOG("Hashed {} page(s) in {} ms", offsetCachePages.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+    );
+}
+
+/**
+ * @brief Looks up the hits of a signature in the offset cache.
+ *
+ * @details
+ * Every cached hit is checked against the signature before it is reused. On the same build
+ * no byte changed, so the cached hits are all the hits there are; if one no longer matches,
+ * the cache is not trusted and the signature is scanned. After a game update, cached hits
+ * are moved along with their section and reused if every page they cover is unchanged and
+ * they still match. Only the runs of changed pages are then rescanned, starting early enough
+ * to catch a hit that begins before a run and ends in it. If most pages changed, or the
+ * cache has no page hashes, the whole module is scanned instead.
+ *
+ * @param patternFind IDA-style byte array pattern.
+ * @param address Vector the absolute addresses of every hit are appended to.
+ * @return bool True if the cache could be used.
+ */
+bool lookupOffsetCache(const char* patternFind, std::vector<uint64_t>* address) {
+    auto dosHeader = (PIMAGE_DOS_HEADER)baseModule;
+    auto ntHeaders = (PIMAGE_NT_HEADERS)((uint8_t*)baseModule + dosHeader->e_lfanew);
+    uintptr_t imageSize = ntHeaders->OptionalHeader.SizeOfImage;
+    size_t length = patternLength(patternFind);
+    if (!offsetCacheSameBuild && offsetCacheChangedPages.empty()) {
+        return false;
+    }
+
+    std::vector<uint64_t> hits;
+    try {
+        YAML::Node entry = offsetCache["signatures"][patternFind];
+        if (!entry || !entry.IsSequence()) {
+            return false;
+        }
+        for (const auto& hit : entry) {
+            uintptr_t rva = hit["rva"].as<uintptr_t>();
+            if (!offsetCacheSameBuild) {
+                auto section = std::find_if(offsetCacheSections.begin(), offsetCacheSections.end(),
+                    [rva](const module_section_t& section) { return rva >= section.rva && rva < section.rva + section.size; }
+                );
+                if (section != offsetCacheSections.end()) {
+                    if (!section->present) {
+                        continue;
+                    }
+                    rva += section->delta;
+                }
+            }
+            if (rva + length > imageSize) {
+                if (offsetCacheSameBuild) {
+                    return false;
+                }
+                continue;
+            }
+            bool changed = false;
+            for (uintptr_t page = rva / pageSize; !offsetCacheSameBuild && page <= (rva + length - 1) / pageSize; page++) {
+                changed |= offsetCacheChangedPages[page];
+            }
+            if (changed) {
+                continue;
+            }
+            if (!Utils::patternMatch((uintptr_t)baseModule + rva, patternFind)) {
+                LOG("Cached hit @ 0x{:x} no longer matches '{}'", rva, patternFind);
+                return false;
+            }
+            hits.push_back((uintptr_t)baseModule + rva);
+        }
+    }
+    catch (const YAML::Exception& e) {
+        LOG("Ignoring corrupt cache entry for '{}': {}", patternFind, e.what());
+        return false;
+    }
+
+    if (!offsetCacheSameBuild) {
+        size_t reused = hits.size();
+        for (const auto& [begin, end] : offsetCacheChangedRuns) {
+            Utils::patternScan(baseModule, patternFind, begin >= length ? begin - (length - 1) : 0, end, &hits);
+        }
+        std::sort(hits.begin(), hits.end());
+        hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+        LOG("Reused {} cached hit(s), {} hit(s) in {} changed run(s)",
+            reused, hits.size() - reused, offsetCacheChangedRuns.size()
+        );
+    }
+    address->insert(address->end(), hits.begin(), hits.end());
+    return true;
+}
+
+/**
+ * @brief Remembers the hits of a signature for `saveOffsetCache`.
+ *
+ * @param patternFind IDA-style byte array pattern.
+ * @param address Absolute addresses of every hit.
+ * @return void
+ */
+void recordOffsetCache(const char* patternFind, const std::vector<uint64_t>& address) {
+    YAML::Node entry(YAML::NodeType::Sequence);
+    for (uint64_t hit : address) {
+        YAML::Node node;
+        node["rva"] = hit - (uintptr_t)baseModule;
+        entry.push_back(node);
+    }
+    offsetCacheHits[patternFind] = entry;
+}
+
+/**
+ * @brief Writes the hits of every signature scanned or reused this launch to the offset cache.
+ *
+ * @return void
+ */
+void saveOffsetCache() {
+    YAML::Node cache;
+    cache["build"] = getBuildId();
+    for (const auto& section : getSections()) {
+        YAML::Node node;
+        node["name"] = section.name;
+        node["rva"] = section.rva;
+        node["size"] = section.size;
+        cache["sections"].push_back(node);
+    }
+    cache["pages"] = YAML::Binary((const unsigned char*)offsetCachePages.data(), offsetCachePages.size() * sizeof(uint64_t));
+    for (const auto& [pattern, entry] : offsetCacheHits) {
+        cache["signatures"][pattern] = entry;
+    }
+    // Written next to the cache and renamed over it, so a crash never leaves a partial cache
+    std::string tempPath = offsetCachePath + ".tmp";
+    {
+        std::ofstream file(tempPath);
+        file << cache;
+        if (!file) {
+            LOG("Failed to write '{}'", tempPath);
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, offsetCachePath, error);
+    if (error) {
+        LOG("Failed to replace '{}': {}", offsetCachePath, error.message());
+        return;
+    }
+    LOG("Saved {} signature(s) to '{}'", offsetCacheHits.size(), offsetCachePath);
+}
+
+/**
+ * @brief Scans the base module for a signature and reports how well it performs.
+ *
+ * @details
+ * Wraps `Utils::patternScan` and logs the number of hits and the time the scan took.
+ * Each fix knows how many hits its signature should produce; a mismatch is logged so
+ * that a signature drifting towards ambiguity (or no longer matching) after a game
+ * update is obvious from the log alone.
+ *
+ * Hits are taken from the offset cache when `lookupOffsetCache` allows it, otherwise the
+ * module is scanned. Either way the result is recorded for `saveOffsetCache`. With
+ * `debug.signatures` enabled the signature's near misses, anchor byte frequency, the
+ * shortest prefix that is still unique and a cheaper signature for the same hits are
+ * logged as well, see `Utils::analyzeSignature`.
+ *
+ * @param patternFind IDA-style byte array pattern.
+ * @param expectedHits Number of hits the signature is expected to produce.
+ * @return std::vector<uint64_t> Absolute addresses of every hit.
+ */
+std::vector<uint64_t> scanSignature(const char* patternFind, size_t expectedHits) {
+    static Utils::Region region("scanSignature");
+    Utils::Region::Scope scope(region);
+    std::vector<uint64_t> addr;
+    auto start = std::chrono::steady_clock::now();
+    bool cached = lookupOffsetCache(patternFind, &addr);
+    if (!cached) {
+        Utils::patternScan(baseModule, patternFind, &addr);
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    LOG("{} '{}' in {} us: {} hit(s), expected {}",
+        cached ? "Reused cached" : "Scanned", patternFind, us, addr.size(), expectedHits
+    );
+    recordOffsetCache(patternFind, addr);
+    if (addr.size() != expectedHits) {
+        LOG("Signature '{}' is not unique enough or no longer matches", patternFind);
+    }
+    if (yml.debug.signatures.enable) {
+        Utils::signature_stats_t stats = Utils::analyzeSignature(baseModule, patternFind);
+        if (stats.nearMisses > 0) {
+            LOG("Nearest miss {} byte(s) off, {} position(s), first @ 0x{:x}",
+                stats.nearMissDistance, stats.nearMisses, stats.nearMissAddress - (uintptr_t)baseModule
+            );
+        }
+        LOG("Anchor 0x{:02X} occurs {} times, rarest byte 0x{:02X} at +{} occurs {} times",
+            stats.anchorByte, stats.anchorCount, stats.rarestByte, stats.rarestOffset, stats.rarestCount
+        );
+        LOG("First {} of {} byte(s) are enough to match only the hits", stats.uniqueLength, patternLength(patternFind));
+        if (!stats.suggestion.empty()) {
+            LOG("Suggested signature '{}' at +{}, its first byte occurs {} times",
+                stats.suggestion, stats.suggestionOffset, stats.suggestionCount
+            );
+        }
+    }
+    return addr;
+}
+
+/**
+ * @brief Names the function containing an address.
+ *
+ * @details
+ * Fixes call this for every function they hook or patch, so that `symbolize` can print a
+ * readable name instead of a bare address.
+ *
+ * @param absAddr Any address inside the function.
+ * @param name Name to show for the function.
+ * @return void
+ */
+void addSymbol(uintptr_t absAddr, const std::string& name) {
+    uintptr_t begin, end;
+    uintptr_t rva = absAddr - (uintptr_t)baseModule;
+    symbols[Utils::findFunction(baseModule, rva, &begin, &end) ? begin : rva] = name;
+}
+
+/**
+ * @brief Turns an address into a readable location for the log.
+ *
+ * @details
+ * The containing function is found through the executable's .pdata with a binary search,
+ * then named from the names registered with `addSymbol`, or `sub_<rva>` otherwise. Leaf
+ * functions, like the FOV accessor, have no .pdata entry and are matched against the
+ * registered names directly. For example: `CodeVein-Win64-Shipping.exe+F7B8B88 (FOV accessor+0x8)`.
+ *
+ * @param absAddr Address to symbolize.
+ * @return std::string
+ */
+std::string symbolize(uintptr_t absAddr) {
+    const uintptr_t maxLeafSize = 0x100;
+    uintptr_t moduleSize = ((PIMAGE_NT_HEADERS)((uint8_t*)baseModule
+        + ((PIMAGE_DOS_HEADER)baseModule)->e_lfanew))->OptionalHeader.SizeOfImage;
+    uintptr_t rva = absAddr - (uintptr_t)baseModule;
+    if (absAddr < (uintptr_t)baseModule || rva >= moduleSize) {
+        return std::format("0x{:X}", absAddr);
+    }
+
+    uintptr_t begin, end;
+    if (!Utils::findFunction(baseModule, rva, &begin, &end)) {
+        // Leaf functions have no .pdata entry, fall back to the closest name below
+        auto it = symbols.upper_bound(rva);
+        if (it == symbols.begin() || rva - std::prev(it)->first >= maxLeafSize) {
+            return std::format("{}+{:X}", moduleName, rva);
+        }
+        --it;
+        return std::format("{}+{:X} ({}+0x{:x})", moduleName, rva, it->second, rva - it->first);
+    }
+    auto it = symbols.find(begin);
+    std::string name = it == symbols.end() ? std::format("sub_{:X}", begin) : it->second;
+    return std::format("{}+{:X} ({}+0x{:x})", moduleName, rva, name, rva - begin);
+}
+
+/**
+ * @brief Loads the decoded instructions of the executable, decoding it on a new build.
+ *
+ * @details
+ * The table is keyed by the build's fingerprint. A table saved for the same build is mapped
+ * from disk, which takes milliseconds; otherwise the executable is decoded on the thread
+ * pool and the table saved for the next launch. Either way this runs before any fix patches
+ * the executable.
+ *
+ * @return void
+ */
+void loadInstructionTable() {
+    if (!yml.debug.instructions.enable) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = instructionTable.load(instructionTablePath, getBuildId());
+    if (!loaded) {
+        instructionTable.build(baseModule, getBuildId());
+    }
+    auto end = std::chrono::steady_clock::now();
+    LOG("{} {} instruction(s) in {} ms", loaded ? "Mapped" : "Decoded", instructionTable.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+    );
+    if (!loaded && !instructionTable.save(instructionTablePath)) {
+        LOG("Failed to write '{}'", instructionTablePath);
+    }
+}
+
+/**
+ * @brief Checks that a hook or patch site decodes to the expected instruction.
+ *
+ * @details
+ * A signature can still match after a game update while the bytes it lands on are no
+ * longer the instruction the fix was written for. The site is decoded with Zydis and the
+ * first few instructions are logged, so the log shows exactly what is being modified.
+ * With `debug.instructions` enabled the site is also looked up in the instruction table, to
+ * log whether the linear sweep of the executable agrees that an instruction starts there.
+ *
+ * @param absAddr Absolute address of the site.
+ * @param expectedMnemonic Mnemonic the first instruction at the site must have.
+ * @return bool True if the site decodes to `expectedMnemonic`.
+ */
+bool validateSite(uintptr_t absAddr, const char* expectedMnemonic) {
+    std::vector<Utils::instruction_t> instructions = Utils::decodeInstructions(absAddr, 3);
+    for (const auto& instruction : instructions) {
+        LOG("{} : {}", symbolize(instruction.address), instruction.text);
+    }
+    if (instructionTable.size() > 0) {
+        uint32_t rva = (uint32_t)(absAddr - (uintptr_t)baseModule);
+        size_t index = instructionTable.find(rva);
+        if (index == SIZE_MAX || instructionTable.offset(index) != rva) {
+            LOG("Site @ 0x{:x} is not an instruction boundary of the linear sweep", rva);
+        }
+        else if (instructionTable.target(index)) {
+            LOG("Site refers to {}", symbolize((uintptr_t)baseModule + instructionTable.target(index)));
+        }
+    }
+    if (instructions.empty() || instructions[0].mnemonic != expectedMnemonic) {
+        LOG("Expected '{}' @ 0x{:x}, refusing to modify",
+            expectedMnemonic, absAddr - (uintptr_t)baseModule
+        );
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Applies a pillar box fix by patching a specific memory pattern.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the pillar box fix is enabled based on the configuration.
+ * 2. Searches for a specific memory pattern in the base module.
+ * 3. Patches the found pattern with a new value to correct the pillar box issue.
+ *
+ * @details
+ * The function first checks if the pillar box fix is enabled according to the configuration. It
+ * then searches for a predefined byte sequence in the memory of the base module. When the pattern
+ * is found, it patches the memory with a new byte sequence to address the pillar box issue.
+ *
+ * The pattern to find and the pattern to use for patching are hardcoded as byte sequences.
+ *
+ * How was this found?
+ * No idea, will update this later.
+ * 
+ * @return void
+ */
+void pillarBoxFix() {
+    const char* patternFind  = "F6 41 2C 01 4C";
+    const char* patternPatch = "F6 41 2C 00";
+
+    bool enable = yml.masterEnable & yml.fix.pillarbox.enable;
+    LOG("Fix {}", enable ? "Enabled" : "Disabled");
+    if (enable) {
+        std::vector<uint64_t> addr = scanSignature(patternFind, 1);
+        uint8_t* hit = addr.empty() ? nullptr : (uint8_t*)addr[0];
+        uintptr_t absAddr = (uintptr_t)hit;
+        uintptr_t relAddr = (uintptr_t)hit - (uintptr_t)baseModule;
+        if (hit) {
+            addSymbol(absAddr, "pillarbox check");
+        }
+        if (hit && validateSite(absAddr, "test")) {
+            LOG("Found '{}' @ 0x{:x}", patternFind, relAddr);
+            Utils::patch(absAddr, patternPatch);
+            LOG("Patched '{}' with '{}'", patternFind, patternPatch);
+        }
+        else {
+            LOG("Did not find '{}'", patternFind);
+        }
+    }
+}
+
+/**
+ * @brief Writes an aspect ratio to every site recorded by `resolutionFix`.
+ *
+ * @details
+ * All sites are staged in one `Utils::PatchBatch`, so they share the protection changes of
+ * the pages they are in.
+ *
+ * @param bytes Aspect ratio as the bytes of the float.
+ * @return bool True if every site was written.
+ */
+bool patchAspectRatioSites(const std::array<uint8_t, sizeof(float)>& bytes) {
+    Utils::PatchBatch batch;
+    for (uintptr_t site : aspectRatioSites) {
+        batch.add(site, bytes.data(), bytes.size());
+    }
+    return batch.commit();
+}
+
+/**
+ * @brief Applies a resolution fix by patching a specific memory pattern.
+ *
+ * This function performs the following tasks:
+ * 1. Logs the current desktop resolution and aspect ratio.
+ * 2. Searches for a specific memory pattern in the base module.
+ * 3. Determines the bytes to patch with, from a matching profile or the aspect ratio.
+ * 4. Patches the found patterns with them.
+ *
+ * @details
+ * The function first logs the desktop resolution and aspect ratio for debugging purposes.
+ * The function performs a pattern scan to find occurrences of a predefined byte sequence in the
+ * memory of the base module. Every occurrence found is then patched with the aspect ratio's
+ * bytes, taken from the profile matching the resolution if there is one, all in one batch.
+ *
+ * The patching is only performed if the fix is enabled according to the configuration.
+ *
+ * How was this found?
+ * All Unreal Engine 4 games store the aspect ratio, a variable amount of times throughout the
+ * executable. It is always hard coded to 16:9 and in order to get the game to render on
+ * ultrawide+ resolutions, it is necessary to patch the aspect ratio to your target ratio,
+ * usually 21:9 or 32:9.
+ * 
+ * So every location that has 16:9 (39 8E E3 3F) will be patched with target aspect ratio
+ * hex pattern, for 21:9: 8E E3 18 40 (typically), for 32:9: 39 8E 63 40.
+ * 
+ * This game has two instances of the 16:9 pattern in the executable, so both will be patched.
+ * 1. CodeVein-Win64-Shipping.exe+6A63D3D
+ * 2. CodeVein-Win64-Shipping.exe+6A64786
+ *
+ * Every patched address is recorded in `aspectRatioSites` so `displayChangeFix` can rewrite
+ * them later without scanning again.
+ * 
+ * @return void
+ */
+void resolutionFix() {
+    const char* patternFind  = "39 8E E3 3F";
+
+    LOG("Desktop resolution: {}x{}",
+        yml.resolution.width, yml.resolution.height
+    );
+    LOG("Aspect Ratio: {}:{} {}",
+        yml.resolution.width / std::gcd(yml.resolution.width, yml.resolution.height),
+        yml.resolution.height / std::gcd(yml.resolution.width, yml.resolution.height),
+        yml.resolution.aspectRatio
+    );
+
+    bool enable = yml.masterEnable & yml.fix.pillarbox.enable;
+    LOG("Fix {}", enable ? "Enabled" : "Disabled");
+    if (enable) {
+        std::vector<uint64_t> addr = scanSignature(patternFind, 2);
+        for (size_t i = 0; i < addr.size(); i++) {
+            uint8_t* hit = (uint8_t*)addr[i];
+            uintptr_t absAddr = (uintptr_t)hit;
+            uintptr_t relAddr = (uintptr_t)hit - (uintptr_t)baseModule;
+            if (hit) {
+                LOG("Found '{}' @ 0x{:x}",
+                    patternFind, relAddr
+                );
+                aspectRatioSites.push_back(absAddr);
+            }
+            else {
+                LOG("Did not find '{}'", patternFind);
+            }
+        }
+        // Use acquired desktop resolution to resolve the bytes the sites are patched with
+        resolution_patch_t patch = resolvePatch(yml.resolution.width, yml.resolution.height);
+        std::string patternPatch = Utils::bytesToString((void*)patch.aspectRatioBytes.data(), patch.aspectRatioBytes.size());
+        if (!aspectRatioSites.empty() && patchAspectRatioSites(patch.aspectRatioBytes)) {
+            LOG("Patched {} site(s) of '{}' with '{}'{}",
+                aspectRatioSites.size(), patternFind, patternPatch, patch.profile ? " (from profile)" : ""
+            );
+        }
+    }
+}
+
+/**
+ * @brief Applies a field of view (FOV) fix by hooking a specific pattern in memory.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the FOV fix is enabled based on the configuration.
+ * 2. Searches for a specific memory pattern in the base module.
+ * 3. Hooks the identified pattern to modify the FOV value.
+ *
+ * @details
+ * The function uses a pattern scan to find a specific byte sequence in the memory of the base module.
+ * If the pattern is found, a hook is created at an offset from the found pattern address. The hook
+ * modifies the FOV value by adjusting it according to the aspect ratio and multiplier specified in
+ * the configuration.
+ *
+ * The hook function calculates the new FOV value using trigonometric functions based on the current
+ * aspect ratio and the configuration multiplier, then applies this new value to the appropriate register.
+ *
+ * How was this found?
+ * With Universal Unreal Engine 4 Unlocker (UUU), through experimentation 68.0 is the default FOV value.
+ * Using cheat engine the FOV value was tracked down to be at 0x4E87_756C and only one instruction
+ * accesses this memory address: F3 0F10 81 9C030000 - movss xmm0,[rcx+0000039C].
+ * Although that is only the instruction that interacts with the FOV value, there are more instructions
  * that paint a picture what is actually going on:
  * 1 - CodeVein-Win64-Shipping.exe+F7B8B80 : F3 0F10 81 9C030000  movss   xmm0,[rcx+0000039C]
  * 2 - CodeVein-Win64-Shipping.exe+F7B8B88 : 0F57 C9              xorps   xmm1,xmm1
@@ -318,6 +1475,11 @@ void resolutionFix() {
  * 
  * Anyway, for this fix it was decided that hooking was the best choice. This is subjective
  * though and wont be going into the details of why this choice was made.
+ *
+ * The accessor runs several times per frame, so the hook body is kept to a single store of
+ * `fovCache`, which is computed once up front by `computeFov` or taken from the profile for
+ * the current resolution. The first call also signals
+ * `cameraReady`, as it means the camera object has been constructed.
  * 
  * @return void
  */
@@ -327,24 +1489,30 @@ void fovFix() {
     bool enable = yml.masterEnable & yml.fix.pillarbox.enable;
     LOG("Fix {}", enable ? "Enabled" : "Disabled");
     if (enable) {
-        std::vector<uint64_t> addr;
-        Utils::patternScan(baseModule, patternFind, &addr);
-        uint8_t* hit = (uint8_t*)addr[0];
+        std::vector<uint64_t> addr = scanSignature(patternFind, 1);
+        uint8_t* hit = addr.empty() ? nullptr : (uint8_t*)addr[0];
         uintptr_t absAddr = (uintptr_t)hit;
         uintptr_t relAddr = (uintptr_t)hit - (uintptr_t)baseModule;
         if (hit) {
+            addSymbol(absAddr, "FOV accessor");
+        }
+        if (hit && validateSite(absAddr + hookOffset, "xorps")) {
             LOG("Found '{}' @ 0x{:x}", patternFind, relAddr);
             uintptr_t hookAbsAddr = absAddr + hookOffset;
             uintptr_t hookRelAddr = relAddr + hookOffset;
+            resolution_patch_t patch = resolvePatch(yml.resolution.width, yml.resolution.height);
+            fovCache = patch.fov;
+            LOG("Cached FOV: {}{}", fovCache.load(), patch.profile ? " (from profile)" : "");
             static SafetyHookMid fovMidHook{};
             fovMidHook = safetyhook::create_mid(reinterpret_cast<void*>(hookAbsAddr),
                 [](SafetyHookContext& ctx) {
-                    float pi = std::numbers::pi_v<float>;
-                    float newFov = atanf(tanf(yml.fix.fov.value * pi / 360.0f) / nativeAspectRatio * yml.resolution.aspectRatio) * 360.0f / pi;
-                    ctx.xmm0.f32[0] = newFov;
+                    ctx.xmm0.f32[0] = fovCache.load(std::memory_order_relaxed);
+                    if (!cameraReady.isSet()) {
+                        cameraReady.signal();
+                    }
                 }
             );
-            LOG("Hooked @ 0x{:x} + 0x{:x} = 0x{:x}", relAddr, hookOffset, hookRelAddr);
+            LOG("Hooked @ 0x{:x} + 0x{:x} = 0x{:x}, {}", relAddr, hookOffset, hookRelAddr, symbolize(hookAbsAddr));
         }
         else {
             LOG("Did not find '{}'", patternFind);
@@ -352,25 +1520,2064 @@ void fovFix() {
     }
 }
 
+/**
+ * @brief Reports the FOV in effect once the game's camera exists.
+ *
+ * @details
+ * Coroutine that suspends on `cameraReady` and is resumed by the `fovFix` hook on the first
+ * call of the camera's FOV accessor, so nothing waits or polls in the meantime. Fixes that
+ * need the engine to reach a certain state are written the same way, awaiting the event
+ * that the corresponding hook signals.
+ *
+ * @return Utils::Task
+ */
+Utils::Task cameraReport() {
+    co_await cameraReady;
+    LOG("Camera constructed, FOV {} in effect", fovCache.load());
+}
+
+/**
+ * @brief Rewrites the aspect ratio sites and FOV cache for a new resolution.
+ *
+ * @details
+ * Only the addresses recorded by `resolutionFix` are touched, so no pattern scan is needed
+ * and the whole update takes a few microseconds. If a profile matches the new resolution,
+ * its precomputed aspect ratio bytes and FOV are applied as they are; otherwise they are
+ * computed from the resolution and the configured FOV. The sites are written as one
+ * `Utils::PatchBatch`.
+ *
+ * @param width New width in pixels.
+ * @param height New height in pixels.
+ * @return void
+ */
+void applyResolution(int width, int height) {
+    if (width == 0 || height == 0) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    resolution_patch_t patch = resolvePatch(width, height);
+    fovCache = patch.fov;
+    setResolution(width, height);
+    bool patched = patchAspectRatioSites(patch.aspectRatioBytes);
+    auto end = std::chrono::steady_clock::now();
+
+    LOG("Resolution changed to {}x{}, aspect ratio {}, FOV {}{}",
+        width, height, patch.aspectRatio, fovCache.load(), patch.profile ? " (from profile)" : ""
+    );
+    LOG("{} {} site(s) with '{}' in {} us",
+        patched ? "Repatched" : "Failed to repatch", aspectRatioSites.size(),
+        Utils::bytesToString((void*)patch.aspectRatioBytes.data(), patch.aspectRatioBytes.size()),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+    );
+}
+
+/**
+ * @brief Window procedure of the hidden display listener window.
+ *
+ * @details
+ * `WM_DISPLAYCHANGE` is broadcast to all top level windows whenever the desktop resolution
+ * changes or the game is moved to another monitor mode, with the new width and height
+ * packed into `lParam`.
+ */
+LRESULT CALLBACK displayChangeProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    if (msg == WM_DISPLAYCHANGE) {
+        applyResolution(LOWORD(lParam), HIWORD(lParam));
+        return 0;
+    }
+    return DefWindowProc(hwnd, msg, wParam, lParam);
+}
+
+/**
+ * @brief Thread body that owns the hidden display listener window.
+ *
+ * @details
+ * Blocks in `GetMessage`, so the thread costs nothing until a display change is broadcast.
+ *
+ * @param lpParameter Unused parameter.
+ * @return Always returns TRUE.
+ */
+DWORD __stdcall displayChangeThread(void* lpParameter) {
+    WNDCLASSA wc{};
+    wc.lpfnWndProc = displayChangeProc;
+    wc.hInstance = GetModuleHandle(NULL);
+    wc.lpszClassName = "CodeVeinFixDisplayListener";
+    RegisterClassA(&wc);
+
+    // Must be a hidden top level window, message-only windows do not receive broadcasts
+    HWND hwnd = CreateWindowExA(0, wc.lpszClassName, "", WS_OVERLAPPED,
+        0, 0, 0, 0, NULL, NULL, wc.hInstance, NULL
+    );
+    if (!hwnd) {
+        LOG("Failed to create listener window: {}", GetLastError());
+        return true;
+    }
+
+    MSG msg;
+    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    return true;
+}
+
+/**
+ * @brief Follows desktop resolution changes while the game is running.
+ *
+ * This function performs the following tasks:
+ * 1. Checks that the resolution comes from the desktop and that `resolutionFix` patched something.
+ * 2. Starts a thread with a hidden window that listens for `WM_DISPLAYCHANGE`.
+ *
+ * @details
+ * Switching monitors or between 21:9 and 32:9 modes used to leave the aspect ratio and FOV
+ * at their startup values until the game was restarted. On every display change the new
+ * aspect ratio is written to the sites already found by `resolutionFix` and the FOV cache
+ * used by `fovFix` is refreshed in the same step.
+ *
+ * A resolution given explicitly in the configuration is left alone.
+ *
+ * @return void
+ */
+void displayChangeFix() {
+    bool enable = followDesktop && !aspectRatioSites.empty();
+    LOG("Fix {}", enable ? "Enabled" : "Disabled");
+    if (enable) {
+        HANDLE handle = CreateThread(NULL, 0, displayChangeThread, 0, NULL, 0);
+        if (handle) {
+            CloseHandle(handle);
+        }
+    }
+}
+
+/**
+ * @brief Thread body of the memory snapshot tool.
+ *
+ * @details
+ * Blocks in `GetMessage` waiting for the F9 hotkey. The first press takes a snapshot, every
+ * following press takes a new one, logs what changed since the previous one and keeps the
+ * new one as the baseline for the next press.
+ *
+ * @param lpParameter Unused parameter.
+ * @return Always returns TRUE.
+ */
+DWORD __stdcall snapshotThread(void* lpParameter) {
+    const int hotkeyId = 1;
+    const size_t maxLoggedChanges = 256;
+    if (!RegisterHotKey(NULL, hotkeyId, MOD_NOREPEAT, VK_F9)) {
+        LOG("Failed to register F9 hotkey: {}", GetLastError());
+        return true;
+    }
+
+    Utils::MemorySnapshot baseline;
+    bool haveBaseline = false;
+    MSG msg;
+    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+        if (msg.message != WM_HOTKEY || msg.wParam != hotkeyId) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        Utils::MemorySnapshot snapshot;
+        snapshot.take();
+        auto taken = std::chrono::steady_clock::now();
+        LOG("Snapshot of {} MB taken in {} ms",
+            snapshot.size() / (1024 * 1024),
+            std::chrono::duration_cast<std::chrono::milliseconds>(taken - start).count()
+        );
+
+        if (haveBaseline) {
+            std::vector<Utils::memory_change_t> changes = baseline.diff(snapshot);
+            auto diffed = std::chrono::steady_clock::now();
+            LOG("{} changed range(s) found in {} ms",
+                changes.size(),
+                std::chrono::duration_cast<std::chrono::milliseconds>(diffed - taken).count()
+            );
+            for (size_t i = 0; i < changes.size() && i < maxLoggedChanges; i++) {
+                const auto& change = changes[i];
+                float oldFloat, newFloat;
+                memcpy(&oldFloat, &change.oldValue, sizeof(float));
+                memcpy(&newFloat, &change.newValue, sizeof(float));
+                LOG("0x{:x} ({} bytes): int {} -> {}, float {} -> {}",
+                    change.address, change.size,
+                    (int32_t)change.oldValue, (int32_t)change.newValue, oldFloat, newFloat
+                );
+            }
+        }
+        baseline = std::move(snapshot);
+        haveBaseline = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Debugging tool to find where the game stores a setting.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the snapshot tool is enabled based on the configuration.
+ * 2. Starts a thread that takes and compares memory snapshots on the F9 hotkey.
+ *
+ * @details
+ * New fix targets, such as where the engine keeps the resolution scale or HUD bounds, are
+ * found by changing a setting in game and looking at what changed in memory. Press F9,
+ * change the setting, press F9 again and the changed addresses are logged together with
+ * their old and new values read as int and float. Each snapshot is a full copy of the
+ * writable memory, so while comparing the process uses about twice that on top.
+ *
+ * @return void
+ */
+void snapshotTool() {
+    bool enable = yml.debug.snapshot.enable;
+    LOG("Tool {}", enable ? "Enabled" : "Disabled");
+    if (enable) {
+        HANDLE handle = CreateThread(NULL, 0, snapshotThread, 0, NULL, 0);
+        if (handle) {
+            CloseHandle(handle);
+        }
+    }
+}
+
+/**
+ * @brief Converts a wide string to UTF-8.
+ *
+ * @param string Wide string.
+ * @return std::string
+ */
+std::string toUtf8(const std::wstring& string) {
+    int size = WideCharToMultiByte(CP_UTF8, 0, string.c_str(), (int)string.size(), NULL, 0, NULL, NULL);
+    std::string result(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, string.c_str(), (int)string.size(), result.data(), size, NULL, NULL);
+    return result;
+}
+
+/**
+ * @brief Returns the calling thread's file trace ring, creating it on first use.
+ *
+ * @details
+ * Every thread that reads files gets its own single producer ring, so recording a read
+ * never takes a lock. The lock is only taken once per thread to register the ring.
+ *
+ * @return Utils::RingBuffer<file_read_t, 1024>&
+ */
+Utils::RingBuffer<file_read_t, 1024>& fileTraceRing() {
+    thread_local Utils::RingBuffer<file_read_t, 1024>* ring = [] {
+        auto ring = new Utils::RingBuffer<file_read_t, 1024>();
+        std::lock_guard lock(fileTraceMutex);
+        fileTraceRings.push_back(ring);
+        return ring;
+    }();
+    return *ring;
+}
+
+/**
+ * @brief Detour of the executable's `CreateFileW` import, starts tracking every file.
+ *
+ * @details
+ * Names are interned, so records only carry an index and stay valid after the handle is
+ * closed. A handle value the system reuses simply replaces the stale entry, which also
+ * covers handles closed without going through `hookedCloseHandle`.
+ */
+HANDLE WINAPI hookedCreateFileW(
+    LPCWSTR fileName, DWORD access, DWORD shareMode, LPSECURITY_ATTRIBUTES security,
+    DWORD disposition, DWORD flags, HANDLE templateFile
+) {
+    HANDLE handle = originalCreateFileW(fileName, access, shareMode, security, disposition, flags, templateFile);
+    if (handle != INVALID_HANDLE_VALUE && fileName) {
+        uint32_t name;
+        {
+            std::lock_guard lock(fileTraceMutex);
+            auto [it, added] = fileTraceNameIds.try_emplace(fileName, (uint32_t)fileTraceNames.size());
+            if (added) {
+                fileTraceNames.push_back(fileName);
+            }
+            name = it->second;
+        }
+        std::unique_lock lock(fileTraceHandlesMutex);
+        traced_file_t& traced = fileTraceHandles[handle];
+        traced.name = name;
+        traced.position = 0;
+    }
+    return handle;
+}
+
+/**
+ * @brief Detour of the executable's `CloseHandle` import, stops tracking closed files.
+ */
+BOOL WINAPI hookedCloseHandle(HANDLE handle) {
+    bool traced;
+    {
+        std::shared_lock lock(fileTraceHandlesMutex);
+        traced = fileTraceHandles.contains(handle);
+    }
+    if (traced) {
+        std::unique_lock lock(fileTraceHandlesMutex);
+        fileTraceHandles.erase(handle);
+    }
+    return originalCloseHandle(handle);
+}
+
+/**
+ * @brief Records the file position after a seek on a tracked file.
+ *
+ * @param file Handle that was seeked.
+ * @param position New file position.
+ * @return void
+ */
+void setTracedPosition(HANDLE file, uint64_t position) {
+    std::shared_lock lock(fileTraceHandlesMutex);
+    auto it = fileTraceHandles.find(file);
+    if (it != fileTraceHandles.end()) {
+        it->second.position.store(position, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Detour of the executable's `SetFilePointerEx` import, follows the file position.
+ */
+BOOL WINAPI hookedSetFilePointerEx(HANDLE file, LARGE_INTEGER distance, PLARGE_INTEGER newPosition, DWORD method) {
+    LARGE_INTEGER position{};
+    BOOL result = originalSetFilePointerEx(file, distance, &position, method);
+    if (result) {
+        setTracedPosition(file, position.QuadPart);
+        if (newPosition) {
+            *newPosition = position;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Detour of the executable's `SetFilePointer` import, follows the file position.
+ */
+DWORD WINAPI hookedSetFilePointer(HANDLE file, LONG distance, PLONG distanceHigh, DWORD method) {
+    DWORD low = originalSetFilePointer(file, distance, distanceHigh, method);
+    DWORD error = GetLastError();
+    if (low != INVALID_SET_FILE_POINTER || error == NO_ERROR) {
+        uint64_t high = distanceHigh ? (uint32_t)*distanceHigh : 0;
+        setTracedPosition(file, (high << 32) | low);
+    }
+    SetLastError(error);
+    return low;
+}
+
+/**
+ * @brief Detour of the executable's `ReadFile` import, records every read.
+ *
+ * @details
+ * Overlapped reads carry their offset. For synchronous reads the position is tracked per
+ * handle from the seek hooks and the bytes read, so recording a read costs no extra system
+ * call. For overlapped reads the duration only covers issuing the request, not its completion.
+ */
+BOOL WINAPI hookedReadFile(HANDLE file, LPVOID buffer, DWORD size, LPDWORD read, LPOVERLAPPED overlapped) {
+    static Utils::Region region("hookedReadFile, including the read");
+    Utils::Region::Scope scope(region);
+    auto start = std::chrono::steady_clock::now();
+    BOOL result = originalReadFile(file, buffer, size, read, overlapped);
+    auto end = std::chrono::steady_clock::now();
+    DWORD error = GetLastError();
+
+    uint32_t name = fileTraceUnnamed;
+    uint64_t offset = 0;
+    if (overlapped) {
+        offset = ((uint64_t)overlapped->OffsetHigh << 32) | overlapped->Offset;
+    }
+    {
+        std::shared_lock lock(fileTraceHandlesMutex);
+        auto it = fileTraceHandles.find(file);
+        if (it != fileTraceHandles.end()) {
+            name = it->second.name;
+            if (!overlapped) {
+                offset = it->second.position.fetch_add(result && read ? *read : 0, std::memory_order_relaxed);
+            }
+        }
+    }
+    if (prefetchFollowing.load(std::memory_order_relaxed) && name != fileTraceUnnamed) {
+        std::lock_guard lock(prefetchReadsMutex);
+        if (prefetchReads.size() < 4096) {
+            prefetchReads.push_back({ name, offset });
+        }
+    }
+    fileTraceRing().push({
+        file, name, offset, size,
+        std::chrono::duration<float, std::milli>(end - start).count(),
+        GetCurrentThreadId(),
+        frameCount.load(std::memory_order_relaxed)
+    });
+    SetLastError(error);
+    return result;
+}
+
+/**
+ * @brief Checks whether a read was covered by the prefetcher.
+ *
+ * @param name Name of the file.
+ * @param offset Offset of the read.
+ * @param size Size of the read.
+ * @return bool True if every byte of the read was prefetched.
+ */
+bool isPrefetched(const std::string& name, uint64_t offset, uint64_t size) {
+    std::lock_guard lock(prefetchMutex);
+    auto it = prefetchedRanges.find(name);
+    if (it == prefetchedRanges.end()) {
+        return false;
+    }
+    for (const auto& range : it->second) {
+        if (offset >= range.offset && offset + size <= range.offset + range.size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads file ranges into the OS file cache.
+ *
+ * @details
+ * Data is read into a small scratch buffer and thrown away; the point is to get it into
+ * the OS file cache before the game needs it. Before every chunk it waits, up to a second,
+ * while `frameUnderLoad` is set. Every range is recorded for `isPrefetched`.
+ *
+ * @param ranges Ranges in the order to read them.
+ * @param pausedMs Incremented by the time spent waiting for frames under load.
+ * @return uint64_t Number of bytes read.
+ */
+uint64_t prefetchRanges(const std::vector<Utils::named_range_t>& ranges, uint64_t* pausedMs) {
+    const DWORD chunkSize = 1024 * 1024;
+    std::vector<uint8_t> buffer(chunkSize);
+    uint64_t bytesRead = 0;
+    for (const auto& [name, range] : ranges) {
+        int size = MultiByteToWideChar(CP_UTF8, 0, name.c_str(), (int)name.size(), NULL, 0);
+        std::wstring path(size, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, name.c_str(), (int)name.size(), path.data(), size);
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL
+        );
+        if (file == INVALID_HANDLE_VALUE) {
+            continue;
+        }
+        LARGE_INTEGER position{};
+        position.QuadPart = range.offset;
+        SetFilePointerEx(file, position, NULL, FILE_BEGIN);
+        for (uint64_t done = 0; done < range.size;) {
+            for (int wait = 0; frameUnderLoad && wait < 100; wait++) {
+                Sleep(10);
+                *pausedMs += 10;
+            }
+            DWORD read = 0;
+            DWORD request = (DWORD)std::min<uint64_t>(chunkSize, range.size - done);
+            if (!ReadFile(file, buffer.data(), request, &read, NULL) || read == 0) {
+                break;
+            }
+            done += read;
+            bytesRead += read;
+        }
+        CloseHandle(file);
+        std::lock_guard lock(prefetchMutex);
+        prefetchedRanges[name].push_back(range);
+    }
+    return bytesRead;
+}
+
+/**
+ * @brief Thread body of the prefetcher.
+ *
+ * @details
+ * Runs in background processing mode, which lowers both the CPU and the I/O priority of the
+ * thread, so the game's own reads always go first. First the ranges the game read in the
+ * first `prefetchLookahead` frames of previous sessions are read. Then, with the file
+ * tracer hooking the game's reads, every 250 ms the reads since are followed: a read of a
+ * traced range, such as the first read on entering an area, prefetches the ranges read
+ * within `prefetchLookahead` frames after it in the trace. This continues until the budget
+ * is spent.
+ *
+ * @param lpParameter Unused parameter.
+ * @return Always returns TRUE.
+ */
+DWORD __stdcall prefetchThread(void* lpParameter) {
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    std::ifstream trace(fileTracePath);
+    if (!trace) {
+        LOG("No '{}' from a previous session, nothing to prefetch", fileTracePath);
+        return true;
+    }
+    uint64_t budget = (uint64_t)std::max(0, yml.prefetch.budget) * 1024 * 1024;
+    Utils::PrefetchPlan plan(trace, budget);
+    trace.close();
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t pausedMs = 0;
+    auto ranges = plan.startup(prefetchLookahead);
+    uint64_t bytesRead = prefetchRanges(ranges, &pausedMs);
+    auto end = std::chrono::steady_clock::now();
+    LOG("Prefetched {} range(s), {} MB in {} ms, {} ms of it paused for frames under load",
+        ranges.size(), bytesRead / (1024 * 1024),
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), pausedMs
+    );
+
+    if (!yml.debug.fileTrace.enable) {
+        LOG("The game's reads are not traced, later reads are not followed");
+    }
+    prefetchFollowing = yml.debug.fileTrace.enable;
+    while (prefetchFollowing && plan.budget() > 0) {
+        Sleep(250);
+        std::vector<std::pair<uint32_t, uint64_t>> reads;
+        {
+            std::lock_guard lock(prefetchReadsMutex);
+            reads.swap(prefetchReads);
+        }
+        for (const auto& [id, offset] : reads) {
+            std::string name;
+            {
+                std::lock_guard lock(fileTraceMutex);
+                name = id < fileTraceNames.size() ? toUtf8(fileTraceNames[id]) : std::string();
+            }
+            ranges = plan.follow(name, offset, prefetchLookahead);
+            if (ranges.empty()) {
+                continue;
+            }
+            pausedMs = 0;
+            start = std::chrono::steady_clock::now();
+            bytesRead = prefetchRanges(ranges, &pausedMs);
+            end = std::chrono::steady_clock::now();
+            LOG("Read of '{}' @ 0x{:x}: prefetched {} following range(s), {} MB in {} ms, {} MB of the budget left",
+                name, offset, ranges.size(), bytesRead / (1024 * 1024),
+                std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(),
+                plan.budget() / (1024 * 1024)
+            );
+        }
+    }
+    prefetchFollowing = false;
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+    return true;
+}
+
+/**
+ * @brief Prefetches the file ranges the game read in previous sessions.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the prefetcher is enabled based on the configuration.
+ * 2. Starts a low priority thread that plans and reads the ranges.
+ *
+ * @details
+ * The ranges come from `CodeVeinFix.trace.csv`, which the file tracer writes, and are read
+ * up to `prefetch.budget` MB. Area transitions are recognized by the game's reads rather
+ * than by an engine event: with the file tracer enabled, a read of a traced range
+ * prefetches what followed it in previous sessions, see `prefetchThread`. The tracer's
+ * reports also state how many of the game's reads were covered by the prefetcher.
+ *
+ * @return void
+ */
+void prefetchFix() {
+    bool enable = yml.masterEnable && yml.prefetch.enable;
+    LOG("Fix {}", enable ? "Enabled" : "Disabled");
+    if (enable) {
+        HANDLE handle = CreateThread(NULL, 0, prefetchThread, 0, NULL, 0);
+        if (handle) {
+            CloseHandle(handle);
+        }
+    }
+}
+
+/**
+ * @brief Summarizes the file reads recorded since the last report and appends them to the trace.
+ *
+ * @details
+ * Runs on the thread pool. Logs the files that took the most time to read, how many reads
+ * ran on the game thread and the frame with the most reads. Every read is appended to
+ * `CodeVeinFix.trace.csv` so hitches can be matched against the I/O that ran during them.
+ * Once the trace grows past `fileTraceMaxSize` it is moved to `CodeVeinFix.trace.old.csv`
+ * and a new one is started, so the prefetcher never has to plan from more than that.
+ *
+ * @return void
+ */
+void reportFileTrace() {
+    typedef struct file_stats_t {
+        size_t reads = 0;
+        uint64_t bytes = 0;
+        double ms = 0.0;
+    } file_stats_t;
+
+    std::vector<file_read_t> reads;
+    std::vector<std::wstring> names;
+    size_t dropped = 0;
+    {
+        std::lock_guard lock(fileTraceMutex);
+        for (auto ring : fileTraceRings) {
+            file_read_t read;
+            while (ring->pop(read)) {
+                reads.push_back(read);
+            }
+            dropped += ring->takeDropped();
+        }
+        names = fileTraceNames;
+    }
+    fileTraceReportPending = false;
+    if (reads.empty()) {
+        return;
+    }
+
+    std::map<std::string, file_stats_t> files;
+    std::map<uint64_t, size_t> readsPerFrame;
+    file_stats_t gameThread;
+    size_t prefetchHits = 0;
+    std::error_code error;
+    if (std::filesystem::file_size(fileTracePath, error) > fileTraceMaxSize && !error) {
+        std::string oldPath = std::filesystem::path(fileTracePath).replace_extension(".old.csv").string();
+        std::filesystem::rename(fileTracePath, oldPath, error);
+        if (error) {
+            LOG("Failed to rotate '{}': {}", fileTracePath, error.message());
+        }
+    }
+    bool header = !std::filesystem::exists(fileTracePath);
+    std::ofstream trace(fileTracePath, std::ios::app);
+    if (header) {
+        trace << "frame,thread,offset,size,ms,name\n";
+    }
+    for (const auto& read : reads) {
+        std::string name = read.name < names.size() ?
+            toUtf8(names[read.name]) : std::format("0x{:x}", (uintptr_t)read.file);
+        auto& stats = files[name];
+        stats.reads++;
+        stats.bytes += read.size;
+        stats.ms += read.durationMs;
+        readsPerFrame[read.frame]++;
+        if (yml.prefetch.enable && isPrefetched(name, read.offset, read.size)) {
+            prefetchHits++;
+        }
+        if (read.threadId == gameThreadId) {
+            gameThread.reads++;
+            gameThread.bytes += read.size;
+            gameThread.ms += read.durationMs;
+        }
+        trace << std::format("{},{},{},{},{:.3f},{}\n",
+            read.frame, read.threadId, read.offset, read.size, read.durationMs, name
+        );
+    }
+
+    std::vector<std::pair<std::string, file_stats_t>> hottest(files.begin(), files.end());
+    std::sort(hottest.begin(), hottest.end(),
+        [](const auto& a, const auto& b) { return a.second.ms > b.second.ms; }
+    );
+    auto busiest = std::max_element(readsPerFrame.begin(), readsPerFrame.end(),
+        [](const auto& a, const auto& b) { return a.second < b.second; }
+    );
+
+    LOG("Reads: {} from {} file(s), {} dropped", reads.size(), files.size(), dropped);
+    LOG("Game thread: {} read(s), {} KB, {:.2f} ms",
+        gameThread.reads, gameThread.bytes / 1024, gameThread.ms
+    );
+    LOG("Busiest frame: {} with {} read(s)", busiest->first, busiest->second);
+    if (yml.prefetch.enable) {
+        LOG("Prefetch: {} hit(s), {} miss(es)", prefetchHits, reads.size() - prefetchHits);
+    }
+    for (size_t i = 0; i < hottest.size() && i < 5; i++) {
+        LOG("Hot file: {} read(s), {} KB, {:.2f} ms : {}",
+            hottest[i].second.reads, hottest[i].second.bytes / 1024, hottest[i].second.ms, hottest[i].first
+        );
+    }
+}
+
+/**
+ * @brief Debugging tool that traces the engine's file reads.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the file tracer is enabled based on the configuration.
+ * 2. Hooks the executable's `CreateFileW`, `ReadFile`, `SetFilePointer`, `SetFilePointerEx`
+ *    and `CloseHandle` imports.
+ *
+ * @details
+ * Used to find out whether loading stutters come from synchronous pak reads on the game
+ * thread. Each read is recorded with its file, offset, size, duration, thread and frame into
+ * a per thread ring buffer. Reports are written on the telemetry interval by the frame hook.
+ *
+ * @return void
+ */
+void fileTraceTool() {
+    bool enable = yml.debug.fileTrace.enable;
+    LOG("Tool {}", enable ? "Enabled" : "Disabled");
+    if (enable) {
+        // Every original is stored before the batch makes any detour reachable
+        Utils::PatchBatch batch;
+        originalCreateFileW = (decltype(&CreateFileW))Utils::hookIat(
+            baseModule, "kernel32.dll", "CreateFileW", (void*)hookedCreateFileW, &batch
+        );
+        originalReadFile = (decltype(&ReadFile))Utils::hookIat(
+            baseModule, "kernel32.dll", "ReadFile", (void*)hookedReadFile, &batch
+        );
+        originalSetFilePointer = (decltype(&SetFilePointer))Utils::hookIat(
+            baseModule, "kernel32.dll", "SetFilePointer", (void*)hookedSetFilePointer, &batch
+        );
+        originalSetFilePointerEx = (decltype(&SetFilePointerEx))Utils::hookIat(
+            baseModule, "kernel32.dll", "SetFilePointerEx", (void*)hookedSetFilePointerEx, &batch
+        );
+        originalCloseHandle = (decltype(&CloseHandle))Utils::hookIat(
+            baseModule, "kernel32.dll", "CloseHandle", (void*)hookedCloseHandle, &batch
+        );
+        batch.commit();
+        LOG("Hooked CreateFileW: {}, ReadFile: {}, SetFilePointer: {}, SetFilePointerEx: {}, CloseHandle: {}",
+            originalCreateFileW != nullptr, originalReadFile != nullptr, originalSetFilePointer != nullptr,
+            originalSetFilePointerEx != nullptr, originalCloseHandle != nullptr
+        );
+    }
+}
+
+/**
+ * @brief Logs the totals of every instrumented region since the previous report.
+ *
+ * @details
+ * Cycles per nanosecond is the rate at which the region's threads were executing while it
+ * ran; close to the clock speed means it was busy on the CPU, far below means it spent most
+ * of its time waiting on page faults, I/O or the scheduler.
+ *
+ * @param when What the totals cover, for the log.
+ * @return void
+ */
+void reportRegions(const char* when) {
+    if (!yml.debug.regions.enable) {
+        return;
+    }
+    for (const auto& stats : Utils::takeRegionStats()) {
+        LOG("Region '{}' ({}): {} call(s), {:.3f} ms, {:.2f} us and {:.1f} kcycles per call, {:.2f} cycles/ns",
+            stats.name, when, stats.calls, stats.ms, 1000.0 * stats.ms / stats.calls,
+            stats.cycles / 1000.0 / stats.calls, stats.ms > 0.0 ? stats.cycles / (stats.ms * 1e6) : 0.0
+        );
+    }
+}
+
+/**
+ * @brief Queues a background job to run in the slack of an upcoming frame.
+ *
+ * @param name Name of the job, jobs of the same name share a cost estimate.
+ * @param job Job to run on the thread pool.
+ * @return void
+ */
+void runInSlack(const char* name, std::function<void()> job) {
+    std::lock_guard lock(slackMutex);
+    slackJobs.push_back({ name, std::chrono::steady_clock::now(), std::move(job) });
+    slackQueued++;
+}
+
+/**
+ * @brief Runs a slack job and updates the cost estimate of its name.
+ *
+ * @param job Job to run.
+ * @return void
+ */
+void runSlackJob(slack_job_t& job) {
+    auto start = std::chrono::steady_clock::now();
+    job.job();
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard lock(slackMutex);
+    auto [it, inserted] = slackEstimates.try_emplace(job.name, ms);
+    if (!inserted) {
+        it->second = it->second * 0.75f + ms * 0.25f;
+    }
+}
+
+/**
+ * @brief Dispatches the queued background jobs that fit in the slack of the frame that just ended.
+ *
+ * @details
+ * Called from `onFrame` on the render thread. The frame budget is the running average frame
+ * time, the pace the game currently holds. The render thread was busy for the frame time
+ * minus the time it spent blocked in `Present`, waiting on the GPU or vsync; the rest of the
+ * budget is the frame's slack. Spikes over the average leave no slack at all.
+ *
+ * Every job name has an estimate of its cost, measured on its previous runs. Jobs are taken
+ * from the front of the queue while their estimates fit into the slack that is left, so the
+ * work dispatched is expected to finish within the slack, before the render thread needs the
+ * cores again. Jobs that have never run are assumed to cost `slackMinMs`. When less than
+ * that is left, `frameUnderLoad` also tells the prefetcher to pause. A job that has waited
+ * `slackMaxDefer` is dispatched regardless, so a game that is CPU bound throughout still
+ * gets its reports.
+ *
+ * @param now Time the frame ended.
+ * @param sample Times of the frame.
+ * @return void
+ */
+void dispatchSlack(std::chrono::steady_clock::time_point now, const frame_sample_t& sample) {
+    static float averageFrameMs = 0.0f;
+    averageFrameMs = averageFrameMs == 0.0f ? sample.frameMs : averageFrameMs * 0.95f + sample.frameMs * 0.05f;
+    float busyMs = sample.frameMs - sample.presentMs;
+    float slackMs = sample.frameMs > averageFrameMs * 1.25f ? 0.0f : std::max(0.0f, averageFrameMs - busyMs);
+    frameUnderLoad = slackMs < slackMinMs;
+    slackBudgetUs += (uint64_t)(slackMs * 1000.0f);
+    slackFrames++;
+    if (slackQueued == 0) {
+        return;
+    }
+
+    std::vector<slack_job_t> jobs;
+    {
+        std::lock_guard lock(slackMutex);
+        while (!slackJobs.empty()) {
+            slack_job_t& front = slackJobs.front();
+            auto estimate = slackEstimates.find(front.name);
+            float costMs = estimate == slackEstimates.end() ? slackMinMs : estimate->second;
+            if (costMs <= slackMs) {
+                slackMs -= costMs;
+                slackDispatched++;
+            }
+            else if (now - front.queued >= slackMaxDefer) {
+                slackMs = 0.0f;
+                slackForced++;
+            }
+            else {
+                slackDeferredFrames++;
+                break;
+            }
+            jobs.push_back(std::move(front));
+            slackJobs.pop_front();
+            slackQueued--;
+        }
+    }
+    for (auto& job : jobs) {
+        Utils::runAsync([job = std::move(job)]() mutable { runSlackJob(job); });
+    }
+}
+
+/**
+ * @brief Estimates how many cycles `QueryThreadCycleTime` counts per millisecond of CPU time.
+ *
+ * @details
+ * Cycle counts have no documented unit, so they are related to the CPU time
+ * `GetThreadTimes` reports for the game and render threads since they started. That time
+ * only advances in scheduler ticks, but both threads run for most of the game's lifetime,
+ * which keeps the error of the ratio small.
+ *
+ * @return double Cycles per millisecond, 0 while neither thread is known.
+ */
+double threadCyclesPerMs() {
+    uint64_t cycles = 0;
+    uint64_t time = 0;
+    for (HANDLE thread : { gameThread, renderThread.load() }) {
+        FILETIME creation, exit, kernel, user;
+        ULONG64 threadCycles = 0;
+        if (!thread || !GetThreadTimes(thread, &creation, &exit, &kernel, &user) ||
+            !QueryThreadCycleTime(thread, &threadCycles)) {
+            continue;
+        }
+        // 100 ns units, the cycle count includes kernel mode as well
+        time += ((uint64_t)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) +
+            ((uint64_t)user.dwHighDateTime << 32 | user.dwLowDateTime);
+        cycles += threadCycles;
+    }
+    return time ? cycles / (time / 10000.0) : 0.0;
+}
+
+/**
+ * @brief Summarizes the frame samples collected since the last report.
+ *
+ * @details
+ * Runs on the thread pool, never on the render thread. Besides frame time statistics it
+ * reports how much of each frame was spent blocked inside `Present`. A large share means
+ * the CPU was waiting on the GPU, a small share with long frames means the game or render
+ * thread is the bottleneck.
+ *
+ * @return void
+ */
+void reportTelemetry() {
+    std::vector<frame_sample_t> samples;
+    frame_sample_t sample;
+    while (telemetryRing.pop(sample)) {
+        samples.push_back(sample);
+    }
+    size_t dropped = telemetryRing.takeDropped();
+    telemetryReportPending = false;
+    if (samples.empty()) {
+        return;
+    }
+
+    double totalFrameMs = 0.0;
+    double totalPresentMs = 0.0;
+    uint64_t totalGameCycles = 0;
+    uint64_t totalRenderCycles = 0;
+    std::vector<float> frameTimes;
+    for (const auto& s : samples) {
+        totalFrameMs += s.frameMs;
+        totalPresentMs += s.presentMs;
+        totalGameCycles += s.gameCycles;
+        totalRenderCycles += s.renderCycles;
+        frameTimes.push_back(s.frameMs);
+    }
+    std::sort(frameTimes.begin(), frameTimes.end());
+    float p99 = frameTimes[std::min(frameTimes.size() - 1, frameTimes.size() * 99 / 100)];
+    double avgFrameMs = totalFrameMs / samples.size();
+
+    LOG("Frames: {}, avg {:.2f} ms ({:.1f} fps), 1% low {:.1f} fps, max {:.2f} ms",
+        samples.size(), avgFrameMs, 1000.0 / avgFrameMs, 1000.0 / p99, frameTimes.back()
+    );
+    LOG("Present: avg {:.2f} ms, {:.0f}% of frame time blocked on GPU, {} sample(s) dropped",
+        totalPresentMs / samples.size(), 100.0 * totalPresentMs / totalFrameMs, dropped
+    );
+    double cyclesPerMs = threadCyclesPerMs();
+    if (cyclesPerMs > 0.0) {
+        double gameMs = totalGameCycles / cyclesPerMs / samples.size();
+        double renderMs = totalRenderCycles / cyclesPerMs / samples.size();
+        double presentMs = totalPresentMs / samples.size();
+        const char* bound = gameMs >= renderMs && gameMs >= presentMs ? "game thread" :
+            renderMs >= presentMs ? "render thread" : "GPU";
+        LOG("Threads: game {:.2f} ms, render {:.2f} ms CPU time per frame, bound by the {}",
+            gameMs, renderMs, bound
+        );
+    }
+    if (yml.masterEnable && yml.memoryGovernor.enable) {
+        LOG("Memory: load {}%, commit {} MB, working set {} MB, video {}/{} MB, shared video {} MB, "
+            "streaming pool {} MB, mip bias {}, {} adjustment(s)",
+            memoryLoad.load(), memoryCommitMb.load(), memoryWorkingSetMb.load(), memoryVideoMb.load(),
+            memoryVideoBudgetMb.load(), memorySharedVideoMb.load(), memoryPoolSize.load(), memoryMipBias.load(),
+            memoryAdjustments.exchange(0)
+        );
+    }
+    if (!yml.benchmark.enable) {
+        reportRegions("telemetry interval");
+    }
+    uint64_t budgetFrames = std::max<uint64_t>(1, slackFrames.exchange(0));
+    LOG("Background jobs: avg slack {:.2f} ms/frame, {} run in frame slack, {} forced after waiting {} s, "
+        "{} frame(s) deferred",
+        slackBudgetUs.exchange(0) / 1000.0 / budgetFrames, slackDispatched.exchange(0), slackForced.exchange(0),
+        std::chrono::duration_cast<std::chrono::seconds>(slackMaxDefer).count(), slackDeferredFrames.exchange(0)
+    );
+}
+
+/**
+ * @brief Strips leading and trailing whitespace, ini files allow it around keys and values.
+ *
+ * @param text Text to trim.
+ * @return std::string Trimmed text.
+ */
+std::string trim(const std::string& text) {
+    const char* whitespace = " \t\r";
+    size_t first = text.find_first_not_of(whitespace);
+    if (first == std::string::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(whitespace) + 1 - first);
+}
+
+/**
+ * @brief Finds the game's Engine.ini in the user's local app data.
+ *
+ * @return std::filesystem::path Path to Engine.ini, empty if `LOCALAPPDATA` is not set.
+ */
+std::filesystem::path getEngineIniPath() {
+    const char* localAppData = std::getenv("LOCALAPPDATA");
+    if (!localAppData) {
+        return {};
+    }
+    return std::filesystem::path(localAppData) / "CodeVein" / "Saved" / "Config" / "WindowsNoEditor" / "Engine.ini";
+}
+
+/**
+ * @brief Sets console variables in the `[SystemSettings]` section of Engine.ini.
+ *
+ * @details
+ * The engine applies `[SystemSettings]` on startup, so the values take effect on the next
+ * launch. Existing lines for the same variables are replaced, whatever whitespace surrounds
+ * their keys; every other line is kept as it is, and the section is created if the file
+ * does not have one. Reads and writes of Engine.ini are serialized, as the tuner and the
+ * memory governor both run on the pool.
+ *
+ * @param cvars Console variables and the values to set them to.
+ * @return bool True if Engine.ini was written.
+ */
+bool writeEngineIni(const std::map<std::string, std::string>& cvars) {
+    std::filesystem::path path = getEngineIniPath();
+    if (path.empty()) {
+        LOG("LOCALAPPDATA not set, cannot find Engine.ini");
+        return false;
+    }
+    std::lock_guard lock(engineIniMutex);
+    std::vector<std::string> lines;
+    bool inSection = false;
+    bool hasSection = false;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        if (trim(line).starts_with("[")) {
+            inSection = trim(line) == "[SystemSettings]";
+        }
+        size_t equals = line.find('=');
+        if (inSection && equals != std::string::npos && cvars.contains(trim(line.substr(0, equals)))) {
+            continue;
+        }
+        lines.push_back(line);
+        if (inSection && !hasSection) {
+            hasSection = true;
+            for (const auto& [cvar, value] : cvars) {
+                lines.push_back(cvar + "=" + value);
+            }
+        }
+    }
+    in.close();
+    if (!hasSection) {
+        lines.push_back("[SystemSettings]");
+        for (const auto& [cvar, value] : cvars) {
+            lines.push_back(cvar + "=" + value);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream out(path);
+    for (const auto& line : lines) {
+        out << line << "\n";
+    }
+    if (!out) {
+        LOG("Failed to write '{}'", path.string());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The tuner's search space as `Utils::tunerAdvance` sees it.
+ */
+Utils::tuner_space_t tunerSpace() {
+    Utils::tuner_space_t space;
+    for (const auto& parameter : yml.tuner.parameters) {
+        space.sizes.push_back(parameter.values.size());
+        space.quality.push_back(parameter.quality);
+    }
+    space.qualityFloor = yml.tuner.qualityFloor;
+    space.passes = yml.tuner.passes;
+    return space;
+}
+
+/**
+ * @brief Identifies the tuner's search space, a saved search is only resumed in the same one.
+ */
+std::string tunerSpaceKey() {
+    std::string space;
+    for (const auto& parameter : yml.tuner.parameters) {
+        space += parameter.cvar + ":" + std::to_string(parameter.values.size());
+        for (double quality : parameter.quality) {
+            space += "," + std::format("{}", quality);
+        }
+        space += ";";
+    }
+    if (yml.tuner.qualityFloor > 0.0) {
+        space += std::format("floor:{};", yml.tuner.qualityFloor);
+    }
+    return space;
+}
+
+/**
+ * @brief Human readable settings of a point in the tuner's search space.
+ */
+std::string tunerDescribe(const std::vector<int>& point) {
+    std::string description;
+    for (size_t i = 0; i < point.size(); i++) {
+        const auto& parameter = yml.tuner.parameters[i];
+        description += (description.empty() ? "" : " ") + parameter.cvar + "=" + parameter.values[point[i]];
+    }
+    return description;
+}
+
+/**
+ * @brief Loads the tuner's search state from a previous launch.
+ *
+ * @details
+ * A state that was saved for a different search space, quality values or floor, or none at
+ * all, starts the search over from the first value of every parameter. If that point is
+ * already below `tuner.qualityFloor` there is nothing to test and the tuner is disabled.
+ *
+ * @return void
+ */
+void loadTuner() {
+    LOG("Tuner {}", yml.tuner.enable ? "Enabled" : "Disabled");
+    if (!yml.tuner.enable) {
+        return;
+    }
+    if (!yml.benchmark.enable || yml.tuner.parameters.empty()) {
+        LOG("Tuner needs the benchmark enabled and at least one parameter");
+        yml.tuner.enable = false;
+        return;
+    }
+    std::string space = tunerSpaceKey();
+    if (!Utils::tunerStart(tunerState, tunerSpace())) {
+        LOG("Tuner: the first value of every parameter is below the quality floor of {}, nothing to test", yml.tuner.qualityFloor);
+        yml.tuner.enable = false;
+        return;
+    }
+    if (std::filesystem::exists(tunerPath)) {
+        try {
+            YAML::Node node = YAML::LoadFile(tunerPath);
+            if (node["space"].as<std::string>() == space) {
+                tunerState.current = node["current"].as<std::vector<int>>();
+                tunerState.best = node["best"].as<std::vector<int>>();
+                tunerState.parameter = node["parameter"].as<size_t>();
+                tunerState.value = node["value"].as<int>();
+                tunerState.pass = node["pass"].as<int>();
+                tunerState.improved = node["improved"].as<bool>();
+                tunerState.applied = node["applied"].as<bool>();
+                tunerState.done = node["done"].as<bool>();
+                tunerState.scores = node["scores"].as<std::map<std::string, double>>();
+            }
+            else {
+                LOG("Parameters changed, starting the search over");
+            }
+        }
+        catch (const YAML::Exception& e) {
+            LOG("Failed to load '{}', starting the search over: {}", tunerPath, e.what());
+        }
+    }
+    if (tunerState.done) {
+        LOG("Search done, best: {}", tunerDescribe(tunerState.best));
+    }
+    else {
+        LOG("Testing: {}{}", tunerDescribe(tunerState.current), tunerState.applied ? "" : " from the next launch");
+    }
+}
+
+/**
+ * @brief Saves the tuner's search state for the next launch.
+ *
+ * @return void
+ */
+void saveTuner() {
+    YAML::Node node;
+    std::string space = tunerSpaceKey();
+    node["space"] = space;
+    node["current"] = tunerState.current;
+    node["best"] = tunerState.best;
+    node["bestSettings"] = tunerDescribe(tunerState.best);
+    node["parameter"] = tunerState.parameter;
+    node["value"] = tunerState.value;
+    node["pass"] = tunerState.pass;
+    node["improved"] = tunerState.improved;
+    node["applied"] = tunerState.applied;
+    node["done"] = tunerState.done;
+    node["scores"] = tunerState.scores;
+    std::ofstream file(tunerPath);
+    file << node;
+}
+
+/**
+ * @brief Scores the finished benchmark run and sets up the next point of the search.
+ *
+ * @details
+ * The engine only reads console variables on startup, so the tuner works across launches:
+ * every benchmark run scores the settings that were in effect and writes the next point to
+ * Engine.ini for the next launch. The first run only writes the starting point, as the
+ * settings in effect are not yet known. Once the search is done the best point is written
+ * and stays in Engine.ini. The search itself is `Utils::tunerRecord`, which never picks a
+ * point below `tuner.qualityFloor`.
+ *
+ * No key press is needed per launch: with `benchmark.start` the run begins on its own once
+ * the camera exists and with `benchmark.exit` the game closes after it, so a script that
+ * relaunches the game until CodeVeinFix.tuner.yml reports `done` closes the loop.
+ *
+ * @param avgFps Average frame rate of the run.
+ * @param low1Fps 1% low frame rate of the run.
+ * @return void
+ */
+void tunerRun(double avgFps, double low1Fps) {
+    if (!yml.tuner.enable || tunerState.done) {
+        return;
+    }
+    if (tunerState.applied) {
+        double score = yml.tuner.target == "avg" ? avgFps : low1Fps;
+        LOG("Tuner: {} scored {:.2f} ({})", tunerDescribe(tunerState.current), score, yml.tuner.target);
+        if (!Utils::tunerRecord(tunerState, tunerSpace(), score)) {
+            LOG("Tuner: search done after {} run(s), best {} with {:.2f}",
+                tunerState.scores.size(), tunerDescribe(tunerState.best), tunerState.scores[Utils::tunerKey(tunerState.best)]
+            );
+        }
+    }
+    std::map<std::string, std::string> cvars;
+    for (size_t i = 0; i < tunerState.current.size(); i++) {
+        cvars[yml.tuner.parameters[i].cvar] = yml.tuner.parameters[i].values[tunerState.current[i]];
+    }
+    tunerState.applied = writeEngineIni(cvars);
+    if (tunerState.applied && !tunerState.done) {
+        LOG("Tuner: next launch tests {}", tunerDescribe(tunerState.current));
+    }
+    saveTuner();
+}
+
+/**
+ * @brief Reads a console variable from the `[SystemSettings]` section of Engine.ini.
+ *
+ * @param cvar Console variable to read.
+ * @return std::string Its value, empty if it is not set.
+ */
+std::string readEngineIni(const std::string& cvar) {
+    std::filesystem::path path = getEngineIniPath();
+    if (path.empty()) {
+        return {};
+    }
+    std::lock_guard lock(engineIniMutex);
+    bool inSection = false;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        size_t equals = line.find('=');
+        if (trim(line).starts_with("[")) {
+            inSection = trim(line) == "[SystemSettings]";
+        }
+        else if (inSection && equals != std::string::npos && trim(line.substr(0, equals)) == cvar) {
+            return trim(line.substr(equals + 1));
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief Samples memory use and steps the texture streaming settings with hysteresis.
+ *
+ * @details
+ * Runs on the thread pool every `memoryGovernor.interval` seconds, queued by `onFrame`.
+ * Paging starts when the whole system runs out of physical memory, so the decision is made
+ * on the system's memory load and on the game's video memory: local video memory used
+ * beyond the budget the OS grants the game spills into shared system memory. The game's
+ * commit and working set are sampled alongside for the telemetry.
+ *
+ * The texture streaming pool's own usage is not sampled. The engine keeps it in its
+ * streaming manager, and this build has no verified signature to reach that. The process'
+ * local video memory from DXGI stands in for it instead: streamed textures are the bulk of
+ * that memory, and it is what spills over when the pool is too large for the card.
+ *
+ * `Utils::MemoryGovernor` decides when to step. Lowering shrinks `r.Streaming.PoolSize`
+ * first. Once the pool is at `minPoolSize`, it raises `r.Streaming.MipBias` instead.
+ * Raising undoes the steps in reverse. Both console variables are only read on startup
+ * and no verified signature of the engine's console manager exists to set them live, so
+ * a step is written to Engine.ini and takes effect on the next launch. The rest of the
+ * session runs on the old settings and so can not show whether the step helped. That is
+ * why at most one step is made per launch; sampling continues for the telemetry.
+ *
+ * @return void
+ */
+void governMemory() {
+    static Utils::MemoryGovernor governor({
+        yml.memoryGovernor.samples, yml.memoryGovernor.high, yml.memoryGovernor.low, yml.memoryGovernor.step,
+        yml.memoryGovernor.minPoolSize, yml.memoryGovernor.maxPoolSize, yml.memoryGovernor.maxMipBias
+    });
+
+    PROCESS_MEMORY_COUNTERS_EX counters{};
+    counters.cb = sizeof(counters);
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)) ||
+        !GlobalMemoryStatusEx(&status)) {
+        return;
+    }
+    memoryCommitMb = counters.PrivateUsage / (1024 * 1024);
+    memoryWorkingSetMb = counters.WorkingSetSize / (1024 * 1024);
+    memoryLoad = status.dwMemoryLoad;
+
+    Utils::memory_sample_t sample;
+    sample.load = memoryLoad;
+    if (IDXGIAdapter3* adapter = gameAdapter.load()) {
+        DXGI_QUERY_VIDEO_MEMORY_INFO local{};
+        DXGI_QUERY_VIDEO_MEMORY_INFO shared{};
+        if (SUCCEEDED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &local)) &&
+            SUCCEEDED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &shared))) {
+            memoryVideoMb = local.CurrentUsage / (1024 * 1024);
+            memoryVideoBudgetMb = local.Budget / (1024 * 1024);
+            memorySharedVideoMb = shared.CurrentUsage / (1024 * 1024);
+            sample.videoOverBudget = local.CurrentUsage > local.Budget;
+            sample.videoHeadroom = local.CurrentUsage < local.Budget / 10 * 9;
+        }
+    }
+
+    if (memoryPoolSize == 0 || memoryAdjusted) {
+        return;
+    }
+    Utils::memory_settings_t current = { memoryPoolSize, memoryMipBias };
+    Utils::memory_settings_t next = governor.step(sample, current);
+    if (next == current) {
+        return;
+    }
+    bool written = writeEngineIni({
+        { "r.Streaming.PoolSize", std::to_string(next.poolSize) },
+        { "r.Streaming.MipBias", std::to_string(next.mipBias) }
+    });
+    LOG("Memory load {}%, commit {} MB, working set {} MB, video {}/{} MB, shared video {} MB: "
+        "streaming pool {} -> {} MB, mip bias {} -> {}{}",
+        memoryLoad.load(), memoryCommitMb.load(), memoryWorkingSetMb.load(), memoryVideoMb.load(),
+        memoryVideoBudgetMb.load(), memorySharedVideoMb.load(), current.poolSize, next.poolSize,
+        current.mipBias, next.mipBias, written ? " from the next launch" : ", failed to write Engine.ini"
+    );
+    if (written) {
+        memoryPoolSize = next.poolSize;
+        memoryMipBias = next.mipBias;
+        memoryAdjustments++;
+        memoryAdjusted = true;
+    }
+}
+
+/**
+ * @brief Keeps the game from paging on systems with little memory.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the memory governor is enabled based on the configuration.
+ * 2. Reads the texture streaming pool size and mip bias currently set in Engine.ini.
+ * 3. Writes `minPoolSize` as the pool size if Engine.ini does not set one.
+ *
+ * @details
+ * Sampling and stepping is done by `governMemory`. Without `r.Streaming.PoolSize` in
+ * Engine.ini the engine sizes the pool from its scalability settings, which can not be read
+ * from outside, so there would be nothing to step from. `minPoolSize` is written instead,
+ * 1000 MB by default, which is what the engine uses at its highest texture quality. The
+ * engine only reads it on startup, so that write is this launch's one change and stepping
+ * starts on the next launch.
+ *
+ * @return void
+ */
+void memoryGovernorFix() {
+    bool enable = yml.masterEnable && yml.memoryGovernor.enable;
+    LOG("Fix {}", enable ? "Enabled" : "Disabled");
+    if (!enable) {
+        return;
+    }
+    const auto& governor = yml.memoryGovernor;
+    std::string poolSize = readEngineIni("r.Streaming.PoolSize");
+    std::string mipBias = readEngineIni("r.Streaming.MipBias");
+    try {
+        if (!poolSize.empty()) {
+            memoryPoolSize = std::clamp(std::stoi(poolSize), governor.minPoolSize, governor.maxPoolSize);
+        }
+        if (!mipBias.empty()) {
+            memoryMipBias = std::clamp(std::stoi(mipBias), 0, governor.maxMipBias);
+        }
+    }
+    catch (const std::exception&) {
+        LOG("Ignoring invalid r.Streaming.PoolSize '{}' or r.Streaming.MipBias '{}' in Engine.ini", poolSize, mipBias);
+    }
+    if (memoryPoolSize == 0) {
+        if (writeEngineIni({ { "r.Streaming.PoolSize", std::to_string(governor.minPoolSize) } })) {
+            LOG("r.Streaming.PoolSize not set in Engine.ini, set to {} MB from the next launch", governor.minPoolSize);
+            memoryPoolSize = governor.minPoolSize;
+            memoryAdjusted = true;
+        }
+        else {
+            LOG("r.Streaming.PoolSize not set in Engine.ini and failed to set it, only sampling memory use");
+        }
+    }
+    else {
+        LOG("Streaming pool: {} MB, mip bias {}", memoryPoolSize.load(), memoryMipBias.load());
+    }
+}
+
+/**
+ * @brief Summarizes a finished benchmark run and appends it to the benchmark file.
+ *
+ * @details
+ * Runs on the thread pool once the run is over. Hitches are frames that took more than
+ * `benchmark.hitch` times the median frame time. The CPU time the game and render threads
+ * spent per frame is reported next to the frame times, see `threadCyclesPerMs`. Every run appends one row to
+ * CodeVeinFix.benchmark.csv, tagged with `benchmark.label` and the resolution, so runs
+ * with different settings can be compared side by side. If `benchmark.exit` is set, the
+ * game window is asked to close afterwards.
+ *
+ * @return void
+ */
+void reportBenchmark() {
+    std::vector<frame_sample_t> samples = std::move(benchmarkSamples);
+    if (!samples.empty()) {
+        double totalFrameMs = 0.0;
+        double totalPresentMs = 0.0;
+        uint64_t totalGameCycles = 0;
+        uint64_t totalRenderCycles = 0;
+        std::vector<float> frameTimes;
+        for (const auto& s : samples) {
+            totalFrameMs += s.frameMs;
+            totalPresentMs += s.presentMs;
+            totalGameCycles += s.gameCycles;
+            totalRenderCycles += s.renderCycles;
+            frameTimes.push_back(s.frameMs);
+        }
+        std::sort(frameTimes.begin(), frameTimes.end());
+        auto percentile = [&frameTimes](size_t p) {
+            return frameTimes[std::min(frameTimes.size() - 1, frameTimes.size() * p / 1000)];
+        };
+        float median = percentile(500);
+        size_t hitches = 0;
+        for (const auto& s : samples) {
+            if (s.frameMs > median * yml.benchmark.hitch) {
+                hitches++;
+            }
+        }
+        double avgFrameMs = totalFrameMs / samples.size();
+        double avgPresentMs = totalPresentMs / samples.size();
+        double cyclesPerMs = threadCyclesPerMs();
+        double gameMs = cyclesPerMs > 0.0 ? totalGameCycles / cyclesPerMs / samples.size() : 0.0;
+        double renderMs = cyclesPerMs > 0.0 ? totalRenderCycles / cyclesPerMs / samples.size() : 0.0;
+
+        LOG("Benchmark '{}': {} frames in {:.1f} s", yml.benchmark.label, samples.size(), totalFrameMs / 1000.0);
+        LOG("Benchmark: avg {:.1f} fps, 1% low {:.1f} fps, 0.1% low {:.1f} fps, max {:.2f} ms",
+            1000.0 / avgFrameMs, 1000.0 / percentile(990), 1000.0 / percentile(999), frameTimes.back()
+        );
+        LOG("Benchmark: {} hitch(es) over {:.2f} ms, avg {:.2f} ms blocked in Present",
+            hitches, median * yml.benchmark.hitch, avgPresentMs
+        );
+        LOG("Benchmark: game thread {:.2f} ms, render thread {:.2f} ms CPU time per frame", gameMs, renderMs);
+
+        bool header = !std::filesystem::exists(benchmarkPath);
+        std::ofstream file(benchmarkPath, std::ios::app);
+        if (header) {
+            file << "label,width,height,frames,avgFps,low1Fps,low01Fps,maxMs,hitches,presentMs,gameMs,renderMs\n";
+        }
+        // Quoted, the label may contain commas or quotes
+        std::string label = "\"";
+        for (char c : yml.benchmark.label) {
+            label += c == '"' ? "\"\"" : std::string(1, c);
+        }
+        label += "\"";
+        resolution_t resolution = getResolution();
+        file << std::format("{},{},{},{},{:.2f},{:.2f},{:.2f},{:.2f},{},{:.3f},{:.3f},{:.3f}\n",
+            label, resolution.width, resolution.height, samples.size(),
+            1000.0 / avgFrameMs, 1000.0 / percentile(990), 1000.0 / percentile(999),
+            frameTimes.back(), hitches, avgPresentMs, gameMs, renderMs
+        );
+        LOG("Benchmark written to '{}'", benchmarkPath);
+        reportRegions("benchmark");
+        tunerRun(1000.0 / avgFrameMs, 1000.0 / percentile(990));
+    }
+    if (yml.benchmark.exit && gameWindow) {
+        LOG("Benchmark done, closing the game");
+        PostMessageW(gameWindow, WM_CLOSE, 0, 0);
+    }
+}
+
+/**
+ * @brief Advances the benchmark run by one frame.
+ *
+ * @details
+ * Called from `onFrame` on the render thread. `Utils::BenchmarkSequencer` decides when the
+ * run starts, on F10 or `benchmark.start` seconds after the camera was constructed, when
+ * the warmup of `benchmark.delay` seconds is over and which frames belong to the recording
+ * of `benchmark.duration` seconds; this function carries out its decisions. Region totals
+ * gathered before the run are reported from the thread pool, and recording only starts
+ * once that report has taken them, so the benchmark's totals cover just the run.
+ *
+ * @param now Time the frame ended.
+ * @param sample Times of the frame.
+ * @return void
+ */
+void benchmarkFrame(std::chrono::steady_clock::time_point now, const frame_sample_t& sample) {
+    static Utils::BenchmarkSequencer sequencer({ yml.benchmark.start, yml.benchmark.delay, yml.benchmark.duration });
+    auto step = sequencer.step(now, cameraReady.isSet(), benchmarkTriggered, benchmarkRegionsReset);
+    if (step.record) {
+        benchmarkSamples.push_back(sample);
+    }
+    switch (step.action) {
+        case Utils::benchmark_action_t::Started:
+            LOG("Benchmark: {}, starting in {} s",
+                sequencer.startedAutomatically() ? "started automatically" : "triggered", yml.benchmark.delay
+            );
+            break;
+        case Utils::benchmark_action_t::ResetRegions:
+            runInSlack("reportRegions", [] {
+                reportRegions("before benchmark");
+                benchmarkRegionsReset = true;
+            });
+            break;
+        case Utils::benchmark_action_t::Recording:
+            LOG("Benchmark: recording for {} s", yml.benchmark.duration);
+            benchmarkSamples.reserve((size_t)yml.benchmark.duration * 240);
+            break;
+        case Utils::benchmark_action_t::Finished:
+            runInSlack("reportBenchmark", reportBenchmark);
+            break;
+        case Utils::benchmark_action_t::None:
+            break;
+    }
+}
+
+/**
+ * @brief Thread body that waits for the benchmark hotkey.
+ *
+ * @details
+ * Blocks in `GetMessage` until F10 is pressed, then arms the run and exits; a launch runs
+ * at most one benchmark, so once a run started on its own the hotkey does nothing.
+ *
+ * @param lpParameter Unused parameter.
+ * @return Always returns TRUE.
+ */
+DWORD __stdcall benchmarkThread(void* lpParameter) {
+    const int hotkeyId = 2;
+    if (!RegisterHotKey(NULL, hotkeyId, MOD_NOREPEAT, VK_F10)) {
+        LOG("Failed to register F10 hotkey: {}", GetLastError());
+        return true;
+    }
+    MSG msg;
+    while (GetMessage(&msg, NULL, 0, 0) > 0) {
+        if (msg.message == WM_HOTKEY && msg.wParam == hotkeyId) {
+            benchmarkTriggered = true;
+            break;
+        }
+    }
+    UnregisterHotKey(NULL, hotkeyId);
+    return true;
+}
+
+/**
+ * @brief Starts the benchmark run on request.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the benchmark is enabled based on the configuration.
+ * 2. Starts a thread that waits for the F10 hotkey.
+ *
+ * @details
+ * With `benchmark.start` set, the run starts on its own that many seconds after the game's
+ * camera was constructed, see `fovFix`, so unattended runs need no input; F10 still starts
+ * it earlier. The camera already exists on the title screen, and the mod cannot tell a
+ * loaded save from the menus, so `start` has to leave time to get to the scene to measure.
+ * A run measures whatever is on screen, a fixed scene keeps runs comparable.
+ *
+ * @return void
+ */
+void benchmarkTool() {
+    LOG("Benchmark {}", yml.benchmark.enable ? "Enabled" : "Disabled");
+    if (yml.benchmark.enable) {
+        HANDLE handle = CreateThread(NULL, 0, benchmarkThread, 0, NULL, 0);
+        if (handle) {
+            CloseHandle(handle);
+        }
+    }
+}
+
+/**
+ * @brief Called by the `Present` hook once per frame.
+ *
+ * @details
+ * Runs on the game's render thread, so it only records a sample, with the CPU cycles the
+ * game thread and this thread ran for since the last frame, into the lock-free telemetry
+ * ring, steps the benchmark run and queues reporting, of telemetry and the file
+ * trace, every `telemetry.interval` seconds. Queued jobs run on the thread pool in the slack
+ * of later frames, see `dispatchSlack`.
+ *
+ * @param presentStart Time the game called `Present`.
+ * @param presentEnd Time `Present` returned.
+ * @return void
+ */
+void onFrame(std::chrono::steady_clock::time_point presentStart, std::chrono::steady_clock::time_point presentEnd) {
+    static std::chrono::steady_clock::time_point lastPresentEnd{};
+    static std::chrono::steady_clock::time_point lastReport = presentEnd;
+    static std::chrono::steady_clock::time_point lastMemorySample = presentEnd;
+    static ULONG64 lastGameCycles = 0;
+    static ULONG64 lastRenderCycles = 0;
+    static Utils::Region region("onFrame");
+    Utils::Region::Scope scope(region);
+    frameCount++;
+
+    ULONG64 gameCycles = 0;
+    ULONG64 renderCycles = 0;
+    if (gameThread) {
+        QueryThreadCycleTime(gameThread, &gameCycles);
+    }
+    QueryThreadCycleTime(GetCurrentThread(), &renderCycles);
+
+    if (lastPresentEnd != std::chrono::steady_clock::time_point{}) {
+        frame_sample_t sample{
+            std::chrono::duration<float, std::milli>(presentEnd - lastPresentEnd).count(),
+            std::chrono::duration<float, std::milli>(presentEnd - presentStart).count(),
+            gameCycles - lastGameCycles,
+            renderCycles - lastRenderCycles
+        };
+        if (yml.telemetry.enable) {
+            telemetryRing.push(sample);
+        }
+        if (yml.benchmark.enable) {
+            benchmarkFrame(presentEnd, sample);
+        }
+        dispatchSlack(presentEnd, sample);
+    }
+    if (yml.masterEnable && yml.memoryGovernor.enable &&
+        presentEnd - lastMemorySample >= std::chrono::seconds(yml.memoryGovernor.interval)) {
+        lastMemorySample = presentEnd;
+        if (!memoryGovernorPending.exchange(true)) {
+            runInSlack("governMemory", [] { governMemory(); memoryGovernorPending = false; });
+        }
+    }
+    if (presentEnd - lastReport >= std::chrono::seconds(yml.telemetry.interval)) {
+        lastReport = presentEnd;
+        if (yml.telemetry.enable && !telemetryReportPending.exchange(true)) {
+            runInSlack("reportTelemetry", reportTelemetry);
+        }
+        if (yml.debug.fileTrace.enable && !fileTraceReportPending.exchange(true)) {
+            runInSlack("reportFileTrace", reportFileTrace);
+        }
+    }
+    lastPresentEnd = presentEnd;
+    lastGameCycles = gameCycles;
+    lastRenderCycles = renderCycles;
+}
+
+/**
+ * @brief Notes the time of the latest gamepad input.
+ *
+ * @details
+ * Runs on the thread pool, as XInput can take a while to report controllers that are not
+ * connected. `GetLastInputInfo` only sees keyboard and mouse, so the gamepads are read
+ * through the XInput DLL the game loaded; if none is loaded gamepads are not seen. Sticks
+ * and triggers inside their dead zones do not count, so a resting stick that drifts does
+ * not keep the game from idling.
+ *
+ * @return void
+ */
+void pollGamepads() {
+    decltype(&XInputGetState) getState = nullptr;
+    for (const char* name : { "xinput1_4.dll", "xinput1_3.dll", "xinput9_1_0.dll" }) {
+        HMODULE module = GetModuleHandleA(name);
+        if (module) {
+            getState = (decltype(&XInputGetState))GetProcAddress(module, "XInputGetState");
+            break;
+        }
+    }
+    for (DWORD user = 0; getState && user < XUSER_MAX_COUNT; user++) {
+        XINPUT_STATE state{};
+        if (getState(user, &state) != ERROR_SUCCESS) {
+            continue;
+        }
+        const XINPUT_GAMEPAD& pad = state.Gamepad;
+        auto outside = [](SHORT x, SHORT y, int deadZone) { return x * x + y * y > deadZone * deadZone; };
+        if (pad.wButtons != 0 ||
+            pad.bLeftTrigger > XINPUT_GAMEPAD_TRIGGER_THRESHOLD || pad.bRightTrigger > XINPUT_GAMEPAD_TRIGGER_THRESHOLD ||
+            outside(pad.sThumbLX, pad.sThumbLY, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE) ||
+            outside(pad.sThumbRX, pad.sThumbRY, XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE)) {
+            lastGamepadInput = GetTickCount();
+        }
+    }
+    gamepadPollPending = false;
+}
+
+/**
+ * @brief Milliseconds since the player last used the keyboard, mouse or a gamepad.
+ *
+ * @return uint64_t
+ */
+uint64_t getInputAge() {
+    DWORD now = GetTickCount();
+    // Tick counts wrap every 49.7 days, unsigned differences stay correct across the wrap
+    DWORD age = now - lastGamepadInput.load();
+    LASTINPUTINFO info{ sizeof(info) };
+    if (GetLastInputInfo(&info)) {
+        age = std::min<DWORD>(age, now - info.dwTime);
+    }
+    return age;
+}
+
+/**
+ * @brief Caps the frame rate while the game is minimized, in the background or idle.
+ *
+ * @details
+ * Called by the `Present` hook after every frame. The window state is checked every frame,
+ * so the cap is lifted on the very next frame once the game is back in use; the decisions
+ * live in `Utils::FrameCap`, this function only gathers its inputs and waits.
+ *
+ * The game's menus do not pause it, as in other online action games, and neither the menu
+ * nor any pause state has been located in the executable. Idling stands in for them: once
+ * no input arrived for `backgroundCap.idle` seconds in the foreground the cap applies as
+ * well, until the next input. Gamepads are polled every 250 ms, see `pollGamepads`.
+ *
+ * `Sleep` rounds up to the system timer tick, 15.6 ms by default, a quarter of a frame at
+ * 15 fps, so the wait uses a high resolution waitable timer. Before Windows 10 1803 there
+ * is none, and the system timer is raised to 1 ms while the cap is in effect instead.
+ *
+ * @param window Window the game presents to.
+ * @param frameStart Time the previous frame ended.
+ * @return void
+ */
+void backgroundCap(HWND window, std::chrono::steady_clock::time_point frameStart) {
+    static Utils::FrameCap cap;
+    static bool highResolution = true;
+    static bool periodRaised = false;
+    static std::chrono::steady_clock::time_point lastPoll{};
+    static HANDLE timer = [] {
+        HANDLE handle = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!handle) {
+            LOG("No high resolution timer, raising the timer resolution while capped");
+            highResolution = false;
+            handle = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+        }
+        return handle;
+    }();
+
+    auto now = std::chrono::steady_clock::now();
+    uint64_t idleAfterMs = (uint64_t)yml.fix.backgroundCap.idle * 1000;
+    if (idleAfterMs != 0 && now - lastPoll >= std::chrono::milliseconds(250) && !gamepadPollPending.exchange(true)) {
+        lastPoll = now;
+        runInSlack("pollGamepads", pollGamepads);
+    }
+    auto decision = cap.step(IsIconic(window), GetForegroundWindow() == window,
+        idleAfterMs != 0 ? getInputAge() : 0, idleAfterMs, yml.fix.backgroundCap.fps, frameStart, now
+    );
+    if (decision.changed) {
+        bool capped = decision.state != Utils::window_state_t::Foreground;
+        if (!capped) {
+            LOG("Window in use, frame rate uncapped");
+        }
+        else {
+            LOG("Window {}, frame rate capped to {} fps",
+                decision.state == Utils::window_state_t::Minimized ? "minimized" :
+                decision.state == Utils::window_state_t::Background ? "in background" : "idle",
+                yml.fix.backgroundCap.fps
+            );
+        }
+        if (!highResolution && capped != periodRaised) {
+            capped ? timeBeginPeriod(1) : timeEndPeriod(1);
+            periodRaised = capped;
+        }
+    }
+    if (decision.delay.count() > 0) {
+        // Relative due times are negative, in 100 ns units
+        LARGE_INTEGER due{};
+        due.QuadPart = -(LONGLONG)decision.delay.count() * 10;
+        if (timer && SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) {
+            WaitForSingleObject(timer, INFINITE);
+        }
+        else {
+            Sleep((DWORD)std::chrono::ceil<std::chrono::milliseconds>(decision.delay).count());
+        }
+    }
+}
+
+/**
+ * @brief Detour of `IDXGISwapChain::Present`, marks the frame boundary.
+ */
+HRESULT __stdcall hookedPresent(IDXGISwapChain* swapChain, UINT syncInterval, UINT flags) {
+    static HWND window = [swapChain] {
+        DXGI_SWAP_CHAIN_DESC desc{};
+        swapChain->GetDesc(&desc);
+        gameWindow = desc.OutputWindow;
+        renderThread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, GetCurrentThreadId());
+        IDXGIDevice* device = nullptr;
+        IDXGIAdapter* adapter = nullptr;
+        IDXGIAdapter3* adapter3 = nullptr;
+        if (SUCCEEDED(swapChain->GetDevice(__uuidof(IDXGIDevice), (void**)&device))) {
+            if (SUCCEEDED(device->GetAdapter(&adapter))) {
+                if (SUCCEEDED(adapter->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&adapter3))) {
+                    gameAdapter = adapter3;
+                }
+                adapter->Release();
+            }
+            device->Release();
+        }
+        return desc.OutputWindow;
+    }();
+    static auto frameStart = std::chrono::steady_clock::now();
+
+    auto presentStart = std::chrono::steady_clock::now();
+    HRESULT result = presentHook.call<HRESULT>(swapChain, syncInterval, flags);
+    onFrame(presentStart, std::chrono::steady_clock::now());
+    if (yml.masterEnable && yml.fix.backgroundCap.enable) {
+        backgroundCap(window, frameStart);
+    }
+    frameStart = std::chrono::steady_clock::now();
+    return result;
+}
+
+/**
+ * @brief Finds the address of `IDXGISwapChain::Present`.
+ *
+ * @details
+ * Creates a throwaway device and swap chain on a hidden window and reads `Present` from
+ * the swap chain's vtable, slot 8, which is shared with the swap chain the game creates.
+ *
+ * @return void* Address of `Present`, nullptr on failure.
+ */
+void* getPresentAddress() {
+    HWND hwnd = CreateWindowExA(0, "STATIC", "", WS_OVERLAPPED,
+        0, 0, 8, 8, NULL, NULL, GetModuleHandle(NULL), NULL
+    );
+    DXGI_SWAP_CHAIN_DESC desc{};
+    desc.BufferCount = 1;
+    desc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    desc.OutputWindow = hwnd;
+    desc.SampleDesc.Count = 1;
+    desc.Windowed = TRUE;
+    desc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+
+    IDXGISwapChain* swapChain = nullptr;
+    ID3D11Device* device = nullptr;
+    ID3D11DeviceContext* context = nullptr;
+    void* present = nullptr;
+    HRESULT result = D3D11CreateDeviceAndSwapChain(
+        nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0, nullptr, 0,
+        D3D11_SDK_VERSION, &desc, &swapChain, &device, nullptr, &context
+    );
+    if (SUCCEEDED(result)) {
+        present = (*(void***)swapChain)[8];
+        context->Release();
+        device->Release();
+        swapChain->Release();
+    }
+    else {
+        LOG("D3D11CreateDeviceAndSwapChain failed: 0x{:x}", (uint32_t)result);
+    }
+    if (hwnd) {
+        DestroyWindow(hwnd);
+    }
+    return present;
+}
+
+/**
+ * @brief Hooks `IDXGISwapChain::Present` to get a callback at every frame boundary.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if anything that needs per frame callbacks is enabled.
+ * 2. Waits for the game to load d3d11.dll.
+ * 3. Hooks `Present` and forwards every frame to `onFrame`.
+ *
+ * @details
+ * Frame time telemetry, benchmark runs, memory sampling and the background frame cap run
+ * here. The engine's own `stat unit` timings have not been located in the shipped
+ * executable, so each frame records the CPU time of the game thread and of the thread
+ * calling `Present`, the render thread, and the time blocked in `Present` stands in for
+ * the GPU's share.
+ *
+ * @return Utils::Task
+ */
+Utils::Task frameHook() {
+    bool enable = yml.telemetry.enable || yml.debug.fileTrace.enable || yml.benchmark.enable ||
+        (yml.masterEnable && (yml.fix.backgroundCap.enable || yml.memoryGovernor.enable));
+    LOG("Hook {}", enable ? "Enabled" : "Disabled");
+    if (!enable) {
+        co_return;
+    }
+    gameThread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, gameThreadId);
+    Utils::Event& d3d11Loaded = Utils::moduleLoaded(L"d3d11.dll");
+    co_await d3d11Loaded;
+
+    void* present = getPresentAddress();
+    if (!present) {
+        LOG("Could not find IDXGISwapChain::Present");
+        co_return;
+    }
+    presentHook = safetyhook::create_inline(present, hookedPresent);
+    LOG("Hooked IDXGISwapChain::Present @ 0x{:x}", (uintptr_t)present);
+}
+
+/**
+ * @brief Counts the overlapped writes that have not completed yet.
+ *
+ * @details
+ * The status of an overlapped write is kept in its `OVERLAPPED`, which belongs to the game
+ * and may already be freed once the write completed, so it is read with
+ * `ReadProcessMemory`, which fails instead of crashing on memory that is gone. Writes that
+ * are no longer pending are forgotten.
+ *
+ * @return size_t Number of overlapped writes still pending.
+ */
+size_t countOverlappedWrites() {
+    const ULONG_PTR statusPending = 0x103;
+    std::lock_guard lock(overlappedWritesMutex);
+    std::erase_if(overlappedWrites, [statusPending](LPOVERLAPPED overlapped) {
+        ULONG_PTR status = 0;
+        return !ReadProcessMemory(GetCurrentProcess(), &overlapped->Internal, &status, sizeof(status), NULL) ||
+            status != statusPending;
+    });
+    return overlappedWrites.size();
+}
+
+/**
+ * @brief Detour of the executable's `WriteFile` import, tracks writes still in progress.
+ *
+ * @details
+ * Synchronous writes are in progress for the duration of the call. Overlapped writes that
+ * return `ERROR_IO_PENDING` are remembered until `countOverlappedWrites` sees them complete.
+ */
+BOOL WINAPI hookedWriteFile(HANDLE file, LPCVOID buffer, DWORD size, LPDWORD written, LPOVERLAPPED overlapped) {
+    pendingWrites++;
+    BOOL result = originalWriteFile(file, buffer, size, written, overlapped);
+    DWORD error = GetLastError();
+    lastWriteTime = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (overlapped && !result && error == ERROR_IO_PENDING) {
+        bool prune;
+        {
+            std::lock_guard lock(overlappedWritesMutex);
+            overlappedWrites.push_back(overlapped);
+            prune = overlappedWrites.size() >= 64;
+        }
+        if (prune) {
+            countOverlappedWrites();
+        }
+    }
+    pendingWrites--;
+    SetLastError(error);
+    return result;
+}
+
+/**
+ * @brief Runs the reports that are still due before the process is terminated.
+ *
+ * @details
+ * Jobs still queued for frame slack are taken off the queue and run right here, as no
+ * more frames may come; once `deadline` has passed the remaining jobs are skipped, and so
+ * are the reports below. A report already running on the thread pool owns its pending flag
+ * until it has drained its ring, so the flag is claimed before reporting the rest; only one
+ * thread ever consumes a ring. If it cannot be claimed before `deadline`, the report is
+ * skipped.
+ *
+ * @param deadline Time by which the reports have to be done.
+ * @return void
+ */
+void flushReports(std::chrono::steady_clock::time_point deadline) {
+    std::deque<slack_job_t> jobs;
+    {
+        std::lock_guard lock(slackMutex);
+        jobs.swap(slackJobs);
+        slackQueued = 0;
+    }
+    size_t skipped = 0;
+    for (auto& job : jobs) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            LOG("Out of time, skipped '{}'", job.name);
+            skipped++;
+            continue;
+        }
+        job.job();
+    }
+    if (skipped > 0) {
+        return;
+    }
+
+    auto claim = [deadline](std::atomic<bool>& pending) {
+        while (pending.exchange(true)) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            Sleep(1);
+        }
+        return true;
+    };
+    if (yml.telemetry.enable) {
+        if (claim(telemetryReportPending)) {
+            reportTelemetry();
+        }
+        else {
+            LOG("Telemetry report still running, skipped");
+        }
+    }
+    if (yml.debug.fileTrace.enable) {
+        if (claim(fileTraceReportPending)) {
+            reportFileTrace();
+        }
+        else {
+            LOG("File trace report still running, skipped");
+        }
+    }
+}
+
+/**
+ * @brief Detour of the executable's `PostQuitMessage` import, the engine's exit request.
+ *
+ * @details
+ * The engine posts the quit message once it has decided to exit, then spends seconds tearing
+ * everything down. Instead, this waits until the game has had no write in flight, synchronous
+ * or overlapped, for a short while, so saves can complete. It then flushes the mod's own
+ * reports and log, and terminates the process. Every step is bounded by `fastExit.timeout`
+ * and logged with its duration.
+ */
+VOID WINAPI hookedPostQuitMessage(int exitCode) {
+    const auto quietPeriod = std::chrono::milliseconds(250);
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(yml.fix.fastExit.timeout);
+    LOG("Exit requested with code {}", exitCode);
+
+    // Wait for saves: no write in flight and none started during the quiet period
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto lastWrite = std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(lastWriteTime.load())
+        );
+        if (pendingWrites == 0 && std::chrono::steady_clock::now() - lastWrite >= quietPeriod &&
+            countOverlappedWrites() == 0) {
+            break;
+        }
+        Sleep(10);
+    }
+    auto writesDone = std::chrono::steady_clock::now();
+    LOG("Writes settled in {} ms{}",
+        std::chrono::duration_cast<std::chrono::milliseconds>(writesDone - start).count(),
+        writesDone >= deadline ? ", timed out" : ""
+    );
+
+    flushReports(deadline);
+    LOG("Terminating after {} ms",
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+    );
+
+    TerminateProcess(GetCurrentProcess(), exitCode);
+}
+
+/**
+ * @brief Skips the engine's slow teardown when quitting.
+ *
+ * This function performs the following tasks:
+ * 1. Checks if the fast exit fix is enabled based on the configuration.
+ * 2. Hooks the executable's `WriteFile` import to know when saves are being written.
+ * 3. Hooks the executable's `PostQuitMessage` import, which the engine calls to exit.
+ *
+ * @details
+ * Opt-in, since it skips everything the engine would do on the way out. Pending writes are
+ * waited for, so a save that is in progress when quitting still completes.
+ *
+ * @return void
+ */
+void fastExitFix() {
+    bool enable = yml.masterEnable && yml.fix.fastExit.enable;
+    LOG("Fix {}", enable ? "Enabled" : "Disabled");
+    if (enable) {
+        Utils::PatchBatch batch;
+        originalWriteFile = (decltype(&WriteFile))Utils::hookIat(
+            baseModule, "kernel32.dll", "WriteFile", (void*)hookedWriteFile, &batch
+        );
+        if (!originalWriteFile) {
+            LOG("Could not hook WriteFile, not enabling fast exit");
+            return;
+        }
+        originalPostQuitMessage = (decltype(&PostQuitMessage))Utils::hookIat(
+            baseModule, "user32.dll", "PostQuitMessage", (void*)hookedPostQuitMessage, &batch
+        );
+        batch.commit();
+        LOG("Hooked PostQuitMessage: {}", originalPostQuitMessage != nullptr);
+    }
+}
+
 /**
  * @brief Main function that initializes and applies various fixes.
  *
  * This function serves as the entry point for the DLL. It performs the following tasks:
- * 1. Initializes the logging system.
- * 2. Reads the configuration from a YAML file.
- * 3. Applies a resolution fix.
- * 4. Applies a pillar box fix.
- * 5. Applies a field of view (FOV) fix.
+ * 1. Places the mod's files next to the DLL and initializes the logging system.
+ * 2. Reads the configuration overrides from a YAML file.
+ * 3. Loads the offset cache, the tuner state and the instruction table.
+ * 4. Applies a resolution fix.
+ * 5. Applies a pillar box fix.
+ * 6. Applies a field of view (FOV) fix.
+ * 7. Saves the offset cache and logs how long startup regions took.
+ * 8. Starts listening for display changes.
+ * 9. Queues fixes that wait for the engine to reach a certain state.
+ * 10. Hooks the frame boundary.
+ * 11. Starts waiting for the benchmark hotkey.
+ * 12. Starts prefetching files read in previous sessions.
+ * 13. Reads the streaming pool size for the memory governor.
+ * 14. Hooks the engine's exit request.
+ * 15. Starts the debugging tools.
  *
  * @param lpParameter Unused parameter.
  * @return Always returns TRUE to indicate successful execution.
  */
 DWORD __stdcall Main(void* lpParameter) {
+    resolvePaths();
     logInit();
     readYml();
+    loadOffsetCache();
+    loadTuner();
+    loadInstructionTable();
     resolutionFix();
     pillarBoxFix();
     fovFix();
+    saveOffsetCache();
+    reportRegions("startup");
+    displayChangeFix();
+    cameraReport();
+    frameHook();
+    benchmarkTool();
+    prefetchFix();
+    memoryGovernorFix();
+    fastExitFix();
+    snapshotTool();
+    fileTraceTool();
     return true;
 }
 
@@ -386,8 +3593,9 @@ DWORD __stdcall Main(void* lpParameter) {
  * different reasons for the call specified by `ul_reason_for_call`. In this implementation:
  *
  * - **DLL_PROCESS_ATTACH**: When the DLL is loaded into the address space of a process, it
- *   creates a new thread to run the `Main` function. The thread priority is set to the highest,
- *   and the thread handle is closed after creation.
+ *   records the calling thread as the game thread and creates a new thread to run the `Main`
+ *   function. The thread priority is set to the highest, and the thread handle is closed after
+ *   creation.
  *
  * - **DLL_THREAD_ATTACH**: Called when a new thread is created in the process. No action is taken
  *   in this implementation.
@@ -411,6 +3619,9 @@ BOOL APIENTRY DllMain(
     switch (ul_reason_for_call) {
     case DLL_PROCESS_ATTACH:
         LOG("DLL_PROCESS_ATTACH");
+        // The loader attaches us on the thread that runs the engine's game loop
+        gameThreadId = GetCurrentThreadId();
+        dllModule = hModule;
         mainHandle = CreateThread(NULL, 0, Main, 0, NULL, 0);
         if (mainHandle)
         {
@@ -27,11 +27,119 @@
 #include <format>
 #include <iostream>
 #include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <cwctype>
+#include <set>
+
+#include "Zydis/Zydis.h"
 
 #include "utils.hpp"
 
 namespace Utils
 {
+    static unsigned int workerLimit = 0;
+    static unsigned int workerCount = 1;
+
+    static PTP_CALLBACK_ENVIRON getThreadPool() {
+        static TP_CALLBACK_ENVIRON environment;
+        static std::once_flag once;
+        std::call_once(once, [] {
+            workerCount = workerLimit;
+            if (workerCount == 0) {
+                workerCount = std::max(1u, std::thread::hardware_concurrency());
+            }
+            InitializeThreadpoolEnvironment(&environment);
+            PTP_POOL pool = CreateThreadpool(NULL);
+            if (pool) {
+                SetThreadpoolThreadMaximum(pool, workerCount);
+                SetThreadpoolThreadMinimum(pool, 1);
+                SetThreadpoolCallbackPool(&environment, pool);
+            }
+            SetThreadpoolCallbackPriority(&environment, TP_CALLBACK_PRIORITY_LOW);
+        });
+        return &environment;
+    }
+
+    // Every participant of a parallelFor owns a deque of indices, kept as the contiguous
+    // range [begin, end). The owner takes from the front, a participant that ran dry
+    // steals the back half of another's deque, so neighbouring indices stay on one thread
+    struct alignas(64) deque_t {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    struct job_t {
+        std::unique_ptr<deque_t[]> deques;
+        size_t participants;
+        std::atomic<size_t> nextSlot;
+        const std::function<void(size_t)>* task;
+    };
+
+    static bool popFront(deque_t& deque, size_t* index) {
+        std::lock_guard lock(deque.mutex);
+        if (deque.begin == deque.end) {
+            return false;
+        }
+        *index = deque.begin++;
+        return true;
+    }
+
+    static bool steal(job_t* job, size_t slot) {
+        deque_t& own = job->deques[slot];
+        for (size_t i = 1; i < job->participants; i++) {
+            deque_t& victim = job->deques[(slot + i) % job->participants];
+            size_t begin, end;
+            {
+                std::lock_guard lock(victim.mutex);
+                if (victim.begin == victim.end) {
+                    continue;
+                }
+                begin = victim.begin + (victim.end - victim.begin) / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            std::lock_guard lock(own.mutex);
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+        return false;
+    }
+
+    static void drainJob(job_t* job) {
+        size_t slot = job->nextSlot++;
+        if (slot >= job->participants) {
+            return;
+        }
+        size_t index;
+        do {
+            while (popFront(job->deques[slot], &index)) {
+                (*job->task)(index);
+            }
+        } while (steal(job, slot));
+    }
+
+    // Workers drop below the game's threads for the duration of a callback; the pool's
+    // callback priority only orders queued callbacks, it does not change thread priority
+    class LowPriority {
+    public:
+        LowPriority() : thread(GetCurrentThread()), previous(GetThreadPriority(thread)) {
+            SetThreadPriority(thread, THREAD_PRIORITY_BELOW_NORMAL);
+        }
+        ~LowPriority() {
+            SetThreadPriority(thread, previous);
+        }
+    private:
+        HANDLE thread;
+        int previous;
+    };
+
     std::string getCompilerInfo() {
 #if defined(__GNUC__)
         std::string compiler = "GCC - "
@@ -91,48 +199,1159 @@ namespace Utils
         VirtualProtect((LPVOID)address, patternBytes.size(), oldProtect, &oldProtect);
     }
 
-    void patternScan(void* module, const char* signature, std::vector<uint64_t>* address)
-    {
-        static auto pattern_to_byte = [](const char* pattern) {
-            auto bytes = std::vector<int>{};
-            auto start = const_cast<char*>(pattern);
-            auto end = const_cast<char*>(pattern) + strlen(pattern);
+    static std::vector<int> parsePattern(const char* pattern) {
+        auto bytes = std::vector<int>{};
+        auto start = const_cast<char*>(pattern);
+        auto end = const_cast<char*>(pattern) + strlen(pattern);
 
-            for (auto current = start; current < end; ++current) {
-                if (*current == '?') {
+        for (auto current = start; current < end; ++current) {
+            if (*current == '?') {
+                ++current;
+                if (*current == '?')
                     ++current;
-                    if (*current == '?')
-                        ++current;
-                    bytes.push_back(-1);
-                }
-                else {
-                    bytes.push_back(strtoul(current, &current, 16));
-                }
+                bytes.push_back(-1);
             }
-            return bytes;
-        };
+            else {
+                bytes.push_back(strtoul(current, &current, 16));
+            }
+        }
+        return bytes;
+    }
 
+    void patternScan(void* module, const char* signature, std::vector<uint64_t>* address)
+    {
+        auto dosHeader = (PIMAGE_DOS_HEADER)module;
+        auto ntHeaders = (PIMAGE_NT_HEADERS)((std::uint8_t*)module + dosHeader->e_lfanew);
+        patternScan(module, signature, 0, ntHeaders->OptionalHeader.SizeOfImage, address);
+    }
+
+    void patternScan(void* module, const char* signature, uintptr_t begin, uintptr_t end, std::vector<uint64_t>* address)
+    {
         auto dosHeader = (PIMAGE_DOS_HEADER)module;
         auto ntHeaders = (PIMAGE_NT_HEADERS)((std::uint8_t*)module + dosHeader->e_lfanew);
 
         auto sizeOfImage = ntHeaders->OptionalHeader.SizeOfImage;
-        auto patternBytes = pattern_to_byte(signature);
+        auto patternBytes = parsePattern(signature);
         auto scanBytes = reinterpret_cast<std::uint8_t*>(module);
 
         auto s = patternBytes.size();
         auto d = patternBytes.data();
 
-        for (auto i = 0ul; i < sizeOfImage - s; ++i) {
-            bool found = true;
-            for (auto j = 0ul; j < s; ++j) {
-                if (scanBytes[i + j] != d[j] && d[j] != -1) {
-                    found = false;
+        // Scan the range in chunks on the thread pool. Chunks partition the start positions
+        // without overlap, and each position is compared against the whole pattern even past
+        // the chunk's end, so a match spanning a boundary is found by exactly one chunk
+        const size_t chunkSize = 4 * 1024 * 1024;
+        size_t scanEnd = std::min<size_t>(end, sizeOfImage - s);
+        if (begin >= scanEnd) {
+            return;
+        }
+        size_t chunkCount = (scanEnd - begin + chunkSize - 1) / chunkSize;
+        std::vector<std::vector<uint64_t>> chunkHits(chunkCount);
+
+        static Region region("patternScan chunk");
+        parallelFor(chunkCount, [&](size_t chunk) {
+            Region::Scope scope(region);
+            size_t first = begin + chunk * chunkSize;
+            size_t last = std::min(first + chunkSize, scanEnd);
+            for (auto i = first; i < last; ++i) {
+                bool found = true;
+                for (auto j = 0ul; j < s; ++j) {
+                    if (scanBytes[i + j] != d[j] && d[j] != -1) {
+                        found = false;
+                        break;
+                    }
+                }
+                if (found) {
+                    chunkHits[chunk].push_back((uint64_t)&scanBytes[i]);
+                }
+            }
+        });
+
+        for (auto& hits : chunkHits) {
+            address->insert(address->end(), hits.begin(), hits.end());
+        }
+    }
+
+    bool patternMatch(uintptr_t address, const char* signature)
+    {
+        auto patternBytes = parsePattern(signature);
+        auto bytes = (const std::uint8_t*)address;
+        for (size_t j = 0; j < patternBytes.size(); ++j) {
+            if (patternBytes[j] != -1 && bytes[j] != patternBytes[j]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    signature_stats_t analyzeSignature(void* module, const char* signature)
+    {
+        std::vector<int> pattern;
+        for (const char* current = signature; *current;) {
+            if (*current == ' ') {
+                ++current;
+            }
+            else if (*current == '?') {
+                current += current[1] == '?' ? 2 : 1;
+                pattern.push_back(-1);
+            }
+            else {
+                char* next;
+                pattern.push_back(strtoul(current, &next, 16));
+                current = next;
+            }
+        }
+
+        auto dosHeader = (PIMAGE_DOS_HEADER)module;
+        auto ntHeaders = (PIMAGE_NT_HEADERS)((std::uint8_t*)module + dosHeader->e_lfanew);
+        size_t sizeOfImage = ntHeaders->OptionalHeader.SizeOfImage;
+        auto bytes = reinterpret_cast<std::uint8_t*>(module);
+        size_t s = pattern.size();
+        signature_stats_t stats{ SIZE_MAX, 0, 0, -1, 0, 0, -1, SIZE_MAX, s };
+        if (s == 0 || s > sizeOfImage) {
+            return stats;
+        }
+
+        typedef struct chunk_t {
+            size_t distance = SIZE_MAX;
+            size_t count = 0;
+            uint64_t address = 0;
+            size_t longestPrefix = 0;
+            std::array<size_t, 256> histogram{};
+        } chunk_t;
+
+        // Same chunks as patternScan, each position's mismatch count stops early once it
+        // exceeds the best distance the chunk has seen
+        const size_t chunkSize = 4 * 1024 * 1024;
+        size_t scanEnd = sizeOfImage - s;
+        size_t chunkCount = (sizeOfImage + chunkSize - 1) / chunkSize;
+        std::vector<chunk_t> chunks(chunkCount);
+        parallelFor(chunkCount, [&](size_t c) {
+            chunk_t& chunk = chunks[c];
+            size_t first = c * chunkSize;
+            size_t last = std::min(first + chunkSize, sizeOfImage);
+            for (size_t i = first; i < last; ++i) {
+                chunk.histogram[bytes[i]]++;
+                if (i >= scanEnd) {
+                    continue;
+                }
+                size_t mismatches = 0;
+                size_t prefix = s;
+                for (size_t j = 0; j < s; ++j) {
+                    if (pattern[j] != -1 && bytes[i + j] != pattern[j]) {
+                        prefix = std::min(prefix, j);
+                        if (++mismatches > chunk.distance) {
+                            break;
+                        }
+                    }
+                }
+                if (mismatches == 0) {
+                    continue;
+                }
+                chunk.longestPrefix = std::max(chunk.longestPrefix, prefix);
+                if (mismatches < chunk.distance) {
+                    chunk.distance = mismatches;
+                    chunk.count = 1;
+                    chunk.address = (uint64_t)&bytes[i];
+                }
+                else if (mismatches == chunk.distance) {
+                    chunk.count++;
+                }
+            }
+        });
+
+        std::array<size_t, 256> histogram{};
+        size_t longestPrefix = 0;
+        for (const auto& chunk : chunks) {
+            for (size_t b = 0; b < histogram.size(); b++) {
+                histogram[b] += chunk.histogram[b];
+            }
+            longestPrefix = std::max(longestPrefix, chunk.longestPrefix);
+            if (chunk.distance < stats.nearMissDistance) {
+                stats.nearMissDistance = chunk.distance;
+                stats.nearMisses = chunk.count;
+                stats.nearMissAddress = chunk.address;
+            }
+            else if (chunk.distance == stats.nearMissDistance) {
+                stats.nearMisses += chunk.count;
+            }
+        }
+        for (size_t j = 0; j < s; ++j) {
+            if (pattern[j] == -1) {
+                continue;
+            }
+            size_t count = histogram[pattern[j]];
+            if (stats.anchorByte == -1) {
+                stats.anchorByte = pattern[j];
+                stats.anchorCount = count;
+            }
+            if (count < stats.rarestCount) {
+                stats.rarestByte = pattern[j];
+                stats.rarestOffset = j;
+                stats.rarestCount = count;
+            }
+        }
+        stats.uniqueLength = std::min(s, longestPrefix + 1);
+
+        auto toSignature = [&pattern](size_t first, size_t length) {
+            while (length > 0 && pattern[first + length - 1] == -1) {
+                length--;
+            }
+            std::string result;
+            for (size_t j = first; j < first + length; ++j) {
+                result += pattern[j] == -1 ? "?? " : std::format("{:02X} ", pattern[j]);
+            }
+            if (!result.empty()) {
+                result.pop_back();
+            }
+            return result;
+        };
+
+        // Windows of the signature starting at a byte rarer than the anchor, rarest first.
+        // A window is cut to one byte past the longest match it has anywhere other than at
+        // a hit shifted by its start; it is unusable if some other position matches it whole
+        const size_t maxWindows = 4;
+        std::vector<size_t> starts;
+        for (size_t k = 1; k < s; ++k) {
+            if (pattern[k] != -1 && histogram[pattern[k]] < stats.anchorCount) {
+                starts.push_back(k);
+            }
+        }
+        std::stable_sort(starts.begin(), starts.end(), [&](size_t a, size_t b) {
+            return histogram[pattern[a]] < histogram[pattern[b]];
+        });
+        starts.resize(std::min(starts.size(), maxWindows));
+        if (!starts.empty()) {
+            std::vector<uint64_t> hits;
+            patternScan(module, signature, &hits);
+            std::sort(hits.begin(), hits.end());
+            std::vector<std::vector<size_t>> longest(chunkCount, std::vector<size_t>(starts.size()));
+            parallelFor(chunkCount, [&](size_t c) {
+                size_t first = c * chunkSize;
+                size_t last = std::min(first + chunkSize, sizeOfImage);
+                for (size_t i = first; i < last; ++i) {
+                    for (size_t w = 0; w < starts.size(); ++w) {
+                        size_t k = starts[w];
+                        if (bytes[i] != pattern[k] || i < k) {
+                            continue;
+                        }
+                        size_t available = std::min(s - k, sizeOfImage - i);
+                        size_t length = 1;
+                        while (length < available &&
+                            (pattern[k + length] == -1 || bytes[i + length] == pattern[k + length])) {
+                            length++;
+                        }
+                        if (length == s - k && std::binary_search(hits.begin(), hits.end(), (uint64_t)&bytes[i - k])) {
+                            continue;
+                        }
+                        longest[c][w] = std::max(longest[c][w], length);
+                    }
+                }
+            });
+            for (size_t w = 0; w < starts.size() && stats.suggestion.empty(); ++w) {
+                size_t k = starts[w];
+                size_t length = 0;
+                for (const auto& chunk : longest) {
+                    length = std::max(length, chunk[w]);
+                }
+                if (length < s - k) {
+                    stats.suggestion = toSignature(k, length + 1);
+                    stats.suggestionOffset = k;
+                    stats.suggestionCount = histogram[pattern[k]];
+                }
+            }
+        }
+        if (stats.suggestion.empty() && stats.uniqueLength < s) {
+            stats.suggestion = toSignature(0, stats.uniqueLength);
+            stats.suggestionOffset = 0;
+            stats.suggestionCount = stats.anchorCount;
+        }
+        return stats;
+    }
+
+    void PatchBatch::add(uintptr_t address, const void* bytes, size_t size) {
+        writes.push_back({ address, std::vector<uint8_t>((const uint8_t*)bytes, (const uint8_t*)bytes + size) });
+    }
+
+    bool PatchBatch::commit() {
+        const size_t pageSize = 0x1000;
+        std::vector<memory_range_t> targets;
+        for (const auto& write : writes) {
+            targets.push_back({ write.address, write.bytes.size() });
+        }
+
+        // A protection change only reports the old protection of its first page, so every
+        // range is split where VirtualQuery says the protection changes
+        typedef struct protected_t {
+            uintptr_t address;
+            size_t size;
+            DWORD protect;
+        } protected_t;
+        std::vector<protected_t> changed;
+        bool writable = true;
+        for (const auto& range : pageRanges(targets, pageSize)) {
+            for (uintptr_t address = range.address; address < range.address + range.size;) {
+                MEMORY_BASIC_INFORMATION info{};
+                if (!VirtualQuery((LPCVOID)address, &info, sizeof(info))) {
+                    writable = false;
                     break;
                 }
+                uintptr_t end = std::min(range.address + range.size, (uintptr_t)info.BaseAddress + info.RegionSize);
+                DWORD oldProtect;
+                if (VirtualProtect((LPVOID)address, end - address, PAGE_EXECUTE_READWRITE, &oldProtect)) {
+                    changed.push_back({ address, end - address, oldProtect });
+                }
+                else {
+                    writable = false;
+                }
+                address = end;
+            }
+        }
+        if (writable) {
+            for (const auto& write : writes) {
+                memcpy((void*)write.address, write.bytes.data(), write.bytes.size());
+            }
+        }
+        for (const auto& range : changed) {
+            DWORD oldProtect;
+            VirtualProtect((LPVOID)range.address, range.size, range.protect, &oldProtect);
+            FlushInstructionCache(GetCurrentProcess(), (LPCVOID)range.address, range.size);
+        }
+        writes.clear();
+        return writable;
+    }
+
+    void* hookIat(void* module, const char* importModule, const char* function, void* detour, PatchBatch* batch)
+    {
+        uint64_t* slot = findImportSlot(module, importModule, function);
+        if (!slot) {
+            return nullptr;
+        }
+        void* original = (void*)*slot;
+        uint64_t value = (uint64_t)detour;
+        if (batch) {
+            batch->add((uintptr_t)slot, &value, sizeof(value));
+        }
+        else {
+            PatchBatch single;
+            single.add((uintptr_t)slot, &value, sizeof(value));
+            single.commit();
+        }
+        return original;
+    }
+
+    bool findFunction(void* module, uintptr_t rva, uintptr_t* begin, uintptr_t* end)
+    {
+        auto base = (std::uint8_t*)module;
+        auto dosHeader = (PIMAGE_DOS_HEADER)module;
+        auto ntHeaders = (PIMAGE_NT_HEADERS)(base + dosHeader->e_lfanew);
+        auto directory = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+        auto functions = (PRUNTIME_FUNCTION)(base + directory.VirtualAddress);
+        auto count = directory.Size / sizeof(RUNTIME_FUNCTION);
+        if (directory.VirtualAddress == 0 || count == 0) {
+            return false;
+        }
+
+        // First function that starts after rva, the one before it is the candidate
+        auto it = std::upper_bound(functions, functions + count, rva,
+            [](uintptr_t rva, const RUNTIME_FUNCTION& function) { return rva < function.BeginAddress; }
+        );
+        if (it == functions) {
+            return false;
+        }
+        --it;
+        if (rva >= it->EndAddress) {
+            return false;
+        }
+        *begin = it->BeginAddress;
+        *end = it->EndAddress;
+        return true;
+    }
+
+    uint64_t hashBytes(const void* data, size_t size) {
+        const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+        const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+        auto bytes = (const uint8_t*)data;
+        uint64_t lanes[4] = { prime1, prime2, ~prime1, ~prime2 };
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            for (size_t lane = 0; lane < 4; lane++) {
+                uint64_t word;
+                memcpy(&word, bytes + i + lane * 8, sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * prime1;
+                lanes[lane] = (lanes[lane] << 31) | (lanes[lane] >> 33);
+            }
+        }
+        uint64_t hash = size;
+        for (size_t lane = 0; lane < 4; lane++) {
+            hash = (hash ^ lanes[lane]) * prime2;
+        }
+        for (; i < size; i++) {
+            hash = (hash ^ bytes[i]) * prime1;
+        }
+        hash ^= hash >> 29;
+        hash *= prime2;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    typedef std::vector<std::pair<uint32_t, PIMAGE_BASE_RELOCATION>> relocation_index_t;
+
+    static const relocation_index_t& getRelocationIndex(void* module) {
+        static std::mutex mutex;
+        static std::map<void*, relocation_index_t> indexes;
+        std::lock_guard lock(mutex);
+
+        auto [it, inserted] = indexes.try_emplace(module);
+        if (!inserted) {
+            return it->second;
+        }
+        static Region region("relocation index build");
+        Region::Scope scope(region);
+        auto base = (std::uint8_t*)module;
+        auto dosHeader = (PIMAGE_DOS_HEADER)module;
+        auto ntHeaders = (PIMAGE_NT_HEADERS)(base + dosHeader->e_lfanew);
+        auto directory = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+
+        // Only block headers are walked here, entries are decoded when a page is hashed
+        auto block = base + directory.VirtualAddress;
+        auto end = block + directory.Size;
+        while (directory.VirtualAddress != 0 && block + sizeof(IMAGE_BASE_RELOCATION) <= end) {
+            auto relocation = (PIMAGE_BASE_RELOCATION)block;
+            if (relocation->SizeOfBlock < sizeof(IMAGE_BASE_RELOCATION)) {
+                break;
+            }
+            it->second.push_back({ relocation->VirtualAddress, relocation });
+            block += relocation->SizeOfBlock;
+        }
+        std::sort(it->second.begin(), it->second.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; }
+        );
+        return it->second;
+    }
+
+    uint64_t hashImage(void* module, uintptr_t rva, size_t size) {
+        const uintptr_t pageSize = 0x1000;
+        const relocation_index_t& index = getRelocationIndex(module);
+        static Region region("hashImage");
+        Region::Scope scope(region);
+        std::vector<std::uint8_t> bytes((std::uint8_t*)module + rva, (std::uint8_t*)module + rva + size);
+
+        // A relocation at the end of the previous page can spill into the range
+        uintptr_t firstPage = (rva & ~(pageSize - 1));
+        firstPage = firstPage >= pageSize ? firstPage - pageSize : 0;
+        auto it = std::lower_bound(index.begin(), index.end(), firstPage,
+            [](const auto& entry, uintptr_t page) { return entry.first < page; }
+        );
+        for (; it != index.end() && it->first < rva + size; ++it) {
+            auto relocation = it->second;
+            auto entries = (WORD*)(relocation + 1);
+            size_t count = (relocation->SizeOfBlock - sizeof(IMAGE_BASE_RELOCATION)) / sizeof(WORD);
+            for (size_t i = 0; i < count; i++) {
+                WORD type = entries[i] >> 12;
+                size_t length = type == IMAGE_REL_BASED_DIR64 ? 8 : type == IMAGE_REL_BASED_HIGHLOW ? 4 : 0;
+                uintptr_t target = relocation->VirtualAddress + (entries[i] & 0xFFF);
+                for (size_t j = 0; j < length; j++) {
+                    if (target + j >= rva && target + j < rva + size) {
+                        bytes[target + j - rva] = 0;
+                    }
+                }
+            }
+        }
+        return hashBytes(bytes.data(), bytes.size());
+    }
+
+    std::vector<uint64_t> hashPages(void* module) {
+        const size_t pageSize = 0x1000;
+        const size_t pagesPerTask = 256;
+        auto dosHeader = (PIMAGE_DOS_HEADER)module;
+        auto ntHeaders = (PIMAGE_NT_HEADERS)((std::uint8_t*)module + dosHeader->e_lfanew);
+        size_t pages = ntHeaders->OptionalHeader.SizeOfImage / pageSize;
+        std::vector<uint64_t> hashes(pages);
+        parallelFor((pages + pagesPerTask - 1) / pagesPerTask, [&](size_t task) {
+            size_t last = std::min(pages, (task + 1) * pagesPerTask);
+            for (size_t page = task * pagesPerTask; page < last; page++) {
+                hashes[page] = hashImage(module, page * pageSize, pageSize);
+            }
+        });
+        return hashes;
+    }
+
+    uint64_t fingerprintModule(void* module) {
+        const size_t pageSize = 0x1000;
+        const size_t samplesPerSection = 16;
+
+        auto dosHeader = (PIMAGE_DOS_HEADER)module;
+        auto ntHeaders = (PIMAGE_NT_HEADERS)((std::uint8_t*)module + dosHeader->e_lfanew);
+        auto sections = IMAGE_FIRST_SECTION(ntHeaders);
+        auto sectionCount = ntHeaders->FileHeader.NumberOfSections;
+
+        uint64_t fields[] = {
+            ntHeaders->FileHeader.TimeDateStamp,
+            ntHeaders->OptionalHeader.CheckSum,
+            ntHeaders->OptionalHeader.SizeOfImage,
+            ntHeaders->OptionalHeader.SizeOfCode,
+            ntHeaders->OptionalHeader.AddressOfEntryPoint,
+            hashBytes(sections, sectionCount * sizeof(IMAGE_SECTION_HEADER))
+        };
+        uint64_t fingerprint = hashBytes(fields, sizeof(fields));
+
+        for (WORD i = 0; i < sectionCount; i++) {
+            const auto& section = sections[i];
+            if (!(section.Characteristics & IMAGE_SCN_MEM_EXECUTE)) {
+                continue;
             }
-            if (found) {
-                address->push_back((uint64_t)&scanBytes[i]);
+            size_t pages = section.Misc.VirtualSize / pageSize;
+            if (pages == 0) {
+                continue;
+            }
+            for (size_t sample = 0; sample < samplesPerSection; sample++) {
+                size_t page = sample * (pages - 1) / (samplesPerSection - 1);
+                uintptr_t rva = section.VirtualAddress + page * pageSize;
+                uint64_t pair[] = { fingerprint, hashImage(module, rva, pageSize) };
+                fingerprint = hashBytes(pair, sizeof(pair));
+            }
+        }
+        return fingerprint;
+    }
+
+    std::vector<instruction_t> decodeInstructions(uintptr_t address, size_t count) {
+        std::vector<instruction_t> instructions;
+        for (size_t i = 0; i < count; i++) {
+            ZydisDisassembledInstruction instruction;
+            // 15 bytes is the longest possible x86 instruction
+            if (!ZYAN_SUCCESS(ZydisDisassembleIntel(
+                ZYDIS_MACHINE_MODE_LONG_64, address, (void*)address, 15, &instruction
+            ))) {
+                break;
+            }
+            instructions.push_back({
+                address,
+                instruction.info.length,
+                ZydisMnemonicGetString(instruction.info.mnemonic),
+                instruction.text
+            });
+            address += instruction.info.length;
+        }
+        return instructions;
+    }
+
+    typedef struct decoded_t {
+        uint32_t offset;
+        uint32_t target;
+        uint8_t length;
+        uint8_t category;
+    } decoded_t;
+
+    static bool decodeAt(const ZydisDecoder* decoder, const uint8_t* base, uint32_t offset, uint32_t limit, decoded_t* decoded) {
+        ZydisDecoderContext context;
+        ZydisDecodedInstruction instruction;
+        if (!ZYAN_SUCCESS(ZydisDecoderDecodeInstruction(
+            decoder, &context, base + offset, limit - offset, &instruction
+        ))) {
+            return false;
+        }
+        *decoded = { offset, 0, instruction.length, (uint8_t)instruction.meta.category };
+        if (instruction.attributes & ZYDIS_ATTRIB_IS_RELATIVE) {
+            ZydisDecodedOperand operands[ZYDIS_MAX_OPERAND_COUNT];
+            if (ZYAN_SUCCESS(ZydisDecoderDecodeOperands(
+                decoder, &context, &instruction, operands, instruction.operand_count
+            ))) {
+                for (size_t i = 0; i < instruction.operand_count; i++) {
+                    const ZydisDecodedOperand& operand = operands[i];
+                    bool relative = (operand.type == ZYDIS_OPERAND_TYPE_IMMEDIATE && operand.imm.is_relative) ||
+                        (operand.type == ZYDIS_OPERAND_TYPE_MEMORY && operand.mem.base == ZYDIS_REGISTER_RIP);
+                    ZyanU64 address;
+                    if (relative && ZYAN_SUCCESS(ZydisCalcAbsoluteAddress(&instruction, &operand, offset, &address))) {
+                        decoded->target = (uint32_t)address;
+                        break;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    InstructionTable::~InstructionTable() {
+        release();
+    }
+
+    void InstructionTable::release() {
+        if (view) {
+            UnmapViewOfFile(view);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        mapping = NULL;
+        view = nullptr;
+        storage.clear();
+        header = nullptr;
+        offsets = targets = nullptr;
+        lengths = categories = nullptr;
+    }
+
+    void InstructionTable::attach(const uint8_t* data) {
+        header = (const header_t*)data;
+        offsets = (const uint32_t*)(data + sizeof(header_t));
+        targets = offsets + header->count;
+        lengths = (const uint8_t*)(targets + header->count);
+        categories = lengths + header->count;
+    }
+
+    void InstructionTable::build(void* module, uint64_t key) {
+        release();
+        auto base = (const uint8_t*)module;
+        auto dosHeader = (PIMAGE_DOS_HEADER)module;
+        auto ntHeaders = (PIMAGE_NT_HEADERS)(base + dosHeader->e_lfanew);
+        auto section = IMAGE_FIRST_SECTION(ntHeaders);
+
+        // Each chunk also knows where its section ends, instructions may run past the chunk
+        typedef struct chunk_t {
+            uint32_t begin;
+            uint32_t end;
+            uint32_t limit;
+            bool continues;
+            std::vector<decoded_t> decoded;
+            uint32_t stop;
+            size_t first;
+            std::vector<decoded_t> prefix;
+        } chunk_t;
+        const uint32_t chunkSize = 1024 * 1024;
+        std::vector<chunk_t> chunks;
+        for (WORD i = 0; i < ntHeaders->FileHeader.NumberOfSections; i++, section++) {
+            if (!(section->Characteristics & IMAGE_SCN_MEM_EXECUTE)) {
+                continue;
+            }
+            uint32_t limit = section->VirtualAddress + section->Misc.VirtualSize;
+            for (uint32_t begin = section->VirtualAddress; begin < limit; begin += chunkSize) {
+                chunks.push_back({ begin, std::min(begin + chunkSize, limit), limit, begin != section->VirtualAddress });
+            }
+        }
+
+        ZydisDecoder decoder;
+        ZydisDecoderInit(&decoder, ZYDIS_MACHINE_MODE_LONG_64, ZYDIS_STACK_WIDTH_64);
+        parallelFor(chunks.size(), [&](size_t c) {
+            chunk_t& chunk = chunks[c];
+            chunk.decoded.reserve(chunkSize / 4);
+            uint32_t offset = chunk.begin;
+            while (offset < chunk.end) {
+                decoded_t decoded;
+                if (decodeAt(&decoder, base, offset, chunk.limit, &decoded)) {
+                    chunk.decoded.push_back(decoded);
+                    offset += decoded.length;
+                }
+                else {
+                    offset++;
+                }
+            }
+            chunk.stop = offset;
+        });
+
+        // Splice the chunks: the previous chunk's last instruction may end inside this one,
+        // so decode on from there until reaching a boundary this chunk found as well. The
+        // instructions decoded on the way are kept as the chunk's prefix
+        size_t count = 0;
+        uint32_t next = 0;
+        for (chunk_t& chunk : chunks) {
+            chunk.first = 0;
+            if (chunk.continues) {
+                while (next < chunk.end) {
+                    auto it = std::lower_bound(chunk.decoded.begin(), chunk.decoded.end(), next,
+                        [](const decoded_t& decoded, uint32_t offset) { return decoded.offset < offset; }
+                    );
+                    if (it != chunk.decoded.end() && it->offset == next) {
+                        chunk.first = it - chunk.decoded.begin();
+                        break;
+                    }
+                    decoded_t decoded;
+                    if (decodeAt(&decoder, base, next, chunk.limit, &decoded)) {
+                        chunk.prefix.push_back(decoded);
+                        next += decoded.length;
+                    }
+                    else {
+                        next++;
+                    }
+                }
+                if (next >= chunk.end) {
+                    chunk.first = chunk.decoded.size();
+                    count += chunk.prefix.size();
+                    continue;
+                }
+            }
+            count += chunk.prefix.size() + chunk.decoded.size() - chunk.first;
+            next = chunk.stop;
+        }
+
+        storage.resize(sizeof(header_t) + count * (2 * sizeof(uint32_t) + 2 * sizeof(uint8_t)));
+        header_t newHeader{ { 'C', 'V', 'I', 'T' }, 1, key, count };
+        memcpy(storage.data(), &newHeader, sizeof(newHeader));
+        attach(storage.data());
+        auto writableOffsets = (uint32_t*)offsets;
+        auto writableTargets = (uint32_t*)targets;
+        auto writableLengths = (uint8_t*)lengths;
+        auto writableCategories = (uint8_t*)categories;
+        size_t i = 0;
+        auto append = [&](const decoded_t& decoded) {
+            writableOffsets[i] = decoded.offset;
+            writableTargets[i] = decoded.target;
+            writableLengths[i] = decoded.length;
+            writableCategories[i] = decoded.category;
+            i++;
+        };
+        for (chunk_t& chunk : chunks) {
+            std::for_each(chunk.prefix.begin(), chunk.prefix.end(), append);
+            std::for_each(chunk.decoded.begin() + chunk.first, chunk.decoded.end(), append);
+            std::vector<decoded_t>().swap(chunk.decoded);
+        }
+    }
+
+    bool InstructionTable::load(const std::string& path, uint64_t key) {
+        release();
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size{};
+        GetFileSizeEx(file, &size);
+        if ((uint64_t)size.QuadPart >= sizeof(header_t)) {
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        }
+        CloseHandle(file);
+        if (mapping) {
+            view = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (!view) {
+            release();
+            return false;
+        }
+        auto candidate = (const header_t*)view;
+        uint64_t expected = sizeof(header_t) + candidate->count * (2 * sizeof(uint32_t) + 2 * sizeof(uint8_t));
+        if (memcmp(candidate->magic, "CVIT", 4) != 0 || candidate->version != 1 || candidate->key != key ||
+            (uint64_t)size.QuadPart != expected) {
+            release();
+            return false;
+        }
+        attach(view);
+        return true;
+    }
+
+    bool InstructionTable::save(const std::string& path) const {
+        if (!header) {
+            return false;
+        }
+        size_t bytes = sizeof(header_t) + size() * (2 * sizeof(uint32_t) + 2 * sizeof(uint8_t));
+        std::string tempPath = path + ".tmp";
+        HANDLE file = CreateFileA(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        auto data = (const uint8_t*)header;
+        bool written = true;
+        for (size_t done = 0; written && done < bytes;) {
+            DWORD part = (DWORD)std::min<size_t>(bytes - done, 64 * 1024 * 1024);
+            DWORD count = 0;
+            written = WriteFile(file, data + done, part, &count, NULL) && count == part;
+            done += count;
+        }
+        CloseHandle(file);
+        return written && MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+
+    size_t InstructionTable::find(uint32_t rva) const {
+        size_t count = size();
+        auto it = std::upper_bound(offsets, offsets + count, rva);
+        if (it == offsets) {
+            return SIZE_MAX;
+        }
+        size_t i = it - offsets - 1;
+        return rva < offsets[i] + lengths[i] ? i : SIZE_MAX;
+    }
+
+    void setWorkerLimit(unsigned int maxWorkers) {
+        workerLimit = maxWorkers;
+    }
+
+    void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) {
+            return;
+        }
+
+        getThreadPool();
+        size_t participants = std::min<size_t>(count, workerCount + 1);
+        job_t job{ std::make_unique<deque_t[]>(participants), participants, 0, &task };
+        for (size_t i = 0; i < participants; i++) {
+            job.deques[i].begin = count * i / participants;
+            job.deques[i].end = count * (i + 1) / participants;
+        }
+        PTP_WORK work = CreateThreadpoolWork(
+            [](PTP_CALLBACK_INSTANCE, PVOID context, PTP_WORK) {
+                LowPriority priority;
+                drainJob((job_t*)context);
+            },
+            &job,
+            getThreadPool()
+        );
+        if (!work) {
+            job.participants = 1;
+            job.deques[0].end = count;
+            drainJob(&job);
+            return;
+        }
+
+        for (size_t i = 1; i < participants; i++) {
+            SubmitThreadpoolWork(work);
+        }
+        drainJob(&job);
+        WaitForThreadpoolWorkCallbacks(work, FALSE);
+        CloseThreadpoolWork(work);
+    }
+
+    void runAsync(std::function<void()> task) {
+        auto context = new std::function<void()>(std::move(task));
+        BOOL submitted = TrySubmitThreadpoolCallback(
+            [](PTP_CALLBACK_INSTANCE, PVOID context) {
+                LowPriority priority;
+                auto task = (std::function<void()>*)context;
+                (*task)();
+                delete task;
+            },
+            context,
+            getThreadPool()
+        );
+        if (!submitted) {
+            (*context)();
+            delete context;
+        }
+    }
+
+    bool Event::await_suspend(std::coroutine_handle<> handle) {
+        std::lock_guard lock(mutex);
+        if (set.load(std::memory_order_acquire)) {
+            return false;
+        }
+        waiters.push_back(handle);
+        return true;
+    }
+
+    void Event::signal() {
+        std::vector<std::coroutine_handle<>> resume;
+        {
+            std::lock_guard lock(mutex);
+            if (set.exchange(true, std::memory_order_acq_rel)) {
+                return;
+            }
+            resume.swap(waiters);
+        }
+        for (auto handle : resume) {
+            handle.resume();
+        }
+    }
+
+    // Loader DLL notification types, these are not part of the public Windows headers
+    typedef struct ldr_unicode_string_t {
+        USHORT Length;
+        USHORT MaximumLength;
+        PWSTR Buffer;
+    } ldr_unicode_string_t;
+
+    typedef struct ldr_dll_loaded_notification_data_t {
+        ULONG Flags;
+        const ldr_unicode_string_t* FullDllName;
+        const ldr_unicode_string_t* BaseDllName;
+        PVOID DllBase;
+        ULONG SizeOfImage;
+    } ldr_dll_loaded_notification_data_t;
+
+    typedef VOID (CALLBACK* ldr_dll_notification_function_t)(
+        ULONG reason, const ldr_dll_loaded_notification_data_t* data, PVOID context
+    );
+    typedef LONG (NTAPI* ldr_register_dll_notification_t)(
+        ULONG flags, ldr_dll_notification_function_t callback, PVOID context, PVOID* cookie
+    );
+
+    static const ULONG ldrDllNotificationReasonLoaded = 1;
+
+    static std::mutex moduleEventsMutex;
+    static std::map<std::wstring, std::unique_ptr<Event>> moduleEvents;
+
+    static std::wstring toLower(std::wstring string) {
+        for (auto& c : string) {
+            c = (wchar_t)std::towlower(c);
+        }
+        return string;
+    }
+
+    static void CALLBACK onDllNotification(
+        ULONG reason, const ldr_dll_loaded_notification_data_t* data, PVOID context
+    ) {
+        if (reason != ldrDllNotificationReasonLoaded) {
+            return;
+        }
+        std::wstring name = toLower(std::wstring(
+            data->BaseDllName->Buffer, data->BaseDllName->Length / sizeof(wchar_t)
+        ));
+
+        Event* event = nullptr;
+        {
+            std::lock_guard lock(moduleEventsMutex);
+            auto it = moduleEvents.find(name);
+            if (it != moduleEvents.end()) {
+                event = it->second.get();
+            }
+        }
+
+        // This runs under the loader lock, resume the waiters on the thread pool instead
+        if (event && !event->isSet()) {
+            TrySubmitThreadpoolCallback(
+                [](PTP_CALLBACK_INSTANCE, PVOID context) {
+                    ((Event*)context)->signal();
+                },
+                event,
+                getThreadPool()
+            );
+        }
+    }
+
+    Event& moduleLoaded(const std::wstring& name) {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            auto ldrRegisterDllNotification = (ldr_register_dll_notification_t)GetProcAddress(
+                GetModuleHandleA("ntdll.dll"), "LdrRegisterDllNotification"
+            );
+            static PVOID cookie = nullptr;
+            if (ldrRegisterDllNotification) {
+                ldrRegisterDllNotification(0, onDllNotification, nullptr, &cookie);
+            }
+        });
+
+        std::wstring key = toLower(name);
+        Event* event;
+        {
+            std::lock_guard lock(moduleEventsMutex);
+            auto& slot = moduleEvents[key];
+            if (!slot) {
+                slot = std::make_unique<Event>();
+            }
+            event = slot.get();
+        }
+        if (GetModuleHandleW(key.c_str())) {
+            event->signal();
+        }
+        return *event;
+    }
+
+    static std::mutex snapshotBuffersMutex;
+    static std::set<uintptr_t> snapshotBuffers;
+
+    MemorySnapshot::MemorySnapshot(MemorySnapshot&& other) noexcept {
+        regions.swap(other.regions);
+    }
+
+    MemorySnapshot& MemorySnapshot::operator=(MemorySnapshot&& other) noexcept {
+        if (this != &other) {
+            release();
+            regions.swap(other.regions);
+        }
+        return *this;
+    }
+
+    MemorySnapshot::~MemorySnapshot() {
+        release();
+    }
+
+    void MemorySnapshot::release() {
+        std::lock_guard lock(snapshotBuffersMutex);
+        for (auto& region : regions) {
+            snapshotBuffers.erase((uintptr_t)region.copy);
+            VirtualFree(region.copy, 0, MEM_RELEASE);
+        }
+        regions.clear();
+    }
+
+    void MemorySnapshot::take() {
+        release();
+
+        // Collect the writable regions first, so our own buffers are not part of the walk
+        const DWORD writable = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+        {
+            std::lock_guard lock(snapshotBuffersMutex);
+            MEMORY_BASIC_INFORMATION info;
+            uintptr_t address = 0;
+            while (VirtualQuery((LPCVOID)address, &info, sizeof(info)) == sizeof(info)) {
+                bool own = snapshotBuffers.contains((uintptr_t)info.AllocationBase);
+                if (info.State == MEM_COMMIT && (info.Protect & writable) && !(info.Protect & PAGE_GUARD) && !own) {
+                    regions.push_back({ (uintptr_t)info.BaseAddress, info.RegionSize, nullptr });
+                }
+                address = (uintptr_t)info.BaseAddress + info.RegionSize;
+            }
+            for (auto& region : regions) {
+                region.copy = (uint8_t*)VirtualAlloc(NULL, region.size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+                if (region.copy) {
+                    snapshotBuffers.insert((uintptr_t)region.copy);
+                }
+            }
+        }
+
+        std::vector<uint8_t> copied(regions.size());
+        parallelFor(regions.size(), [&](size_t i) {
+            SIZE_T read = 0;
+            copied[i] = regions[i].copy && ReadProcessMemory(
+                GetCurrentProcess(), (LPCVOID)regions[i].base, regions[i].copy, regions[i].size, &read
+            ) && read == regions[i].size;
+        });
+
+        // Drop regions that could not be copied, e.g. freed while the snapshot was taken
+        std::vector<region_t> kept;
+        for (size_t i = 0; i < regions.size(); i++) {
+            if (copied[i]) {
+                kept.push_back(regions[i]);
+            }
+            else if (regions[i].copy) {
+                std::lock_guard lock(snapshotBuffersMutex);
+                snapshotBuffers.erase((uintptr_t)regions[i].copy);
+                VirtualFree(regions[i].copy, 0, MEM_RELEASE);
+            }
+        }
+        regions.swap(kept);
+    }
+
+    size_t MemorySnapshot::size() const {
+        size_t total = 0;
+        for (const auto& region : regions) {
+            total += region.size;
+        }
+        return total;
+    }
+
+    std::vector<memory_change_t> MemorySnapshot::diff(const MemorySnapshot& newer) const {
+        const size_t chunkSize = 1024 * 1024;
+        const size_t blockSize = 64;
+
+        typedef struct chunk_t {
+            const region_t* before;
+            const region_t* after;
+            size_t offset;
+            size_t size;
+        } chunk_t;
+
+        // Pair up regions at the same address and size, both lists are sorted by address
+        std::vector<chunk_t> chunks;
+        auto before = regions.begin();
+        auto after = newer.regions.begin();
+        while (before != regions.end() && after != newer.regions.end()) {
+            if (before->base < after->base) {
+                ++before;
+            }
+            else if (after->base < before->base) {
+                ++after;
+            }
+            else {
+                if (before->size == after->size) {
+                    for (size_t offset = 0; offset < before->size; offset += chunkSize) {
+                        chunks.push_back({ &*before, &*after, offset, std::min(chunkSize, before->size - offset) });
+                    }
+                }
+                ++before;
+                ++after;
+            }
+        }
+
+        std::vector<std::vector<memory_change_t>> chunkChanges(chunks.size());
+        static Region region("MemorySnapshot diff chunk");
+        parallelFor(chunks.size(), [&](size_t c) {
+            Region::Scope scope(region);
+            const chunk_t& chunk = chunks[c];
+            const uint8_t* oldBytes = chunk.before->copy + chunk.offset;
+            const uint8_t* newBytes = chunk.after->copy + chunk.offset;
+            auto& changes = chunkChanges[c];
+            for (size_t block = 0; block < chunk.size; block += blockSize) {
+                size_t length = std::min(blockSize, chunk.size - block);
+                if (memcmp(oldBytes + block, newBytes + block, length) == 0) {
+                    continue;
+                }
+                for (size_t i = block; i + 4 <= block + length; i += 4) {
+                    uint32_t oldValue, newValue;
+                    memcpy(&oldValue, oldBytes + i, 4);
+                    memcpy(&newValue, newBytes + i, 4);
+                    if (oldValue == newValue) {
+                        continue;
+                    }
+                    uintptr_t address = chunk.before->base + chunk.offset + i;
+                    if (!changes.empty() && changes.back().address + changes.back().size == address) {
+                        changes.back().size += 4;
+                    }
+                    else {
+                        changes.push_back({ address, 4, oldValue, newValue });
+                    }
+                }
+            }
+        });
+
+        std::vector<memory_change_t> changes;
+        for (auto& chunk : chunkChanges) {
+            for (auto& change : chunk) {
+                if (!changes.empty() && changes.back().address + changes.back().size == change.address) {
+                    changes.back().size += change.size;
+                }
+                else {
+                    changes.push_back(change);
+                }
+            }
+        }
+        return changes;
+    }
+
+    static std::atomic<bool> regionsEnabled = false;
+    static std::mutex regionsMutex;
+    static std::vector<Region*> regionList;
+
+    Region::Region(const char* name) : name(name) {
+        std::lock_guard lock(regionsMutex);
+        regionList.push_back(this);
+    }
+
+    Region::Scope::Scope(Region& region) : region(region), active(regionsEnabled.load(std::memory_order_relaxed)) {
+        if (!active) {
+            return;
+        }
+        LARGE_INTEGER ticks;
+        QueryPerformanceCounter(&ticks);
+        QueryThreadCycleTime(GetCurrentThread(), &startCycles);
+        startTicks = ticks.QuadPart;
+    }
+
+    Region::Scope::~Scope() {
+        if (!active) {
+            return;
+        }
+        uint64_t cycles;
+        QueryThreadCycleTime(GetCurrentThread(), &cycles);
+        LARGE_INTEGER ticks;
+        QueryPerformanceCounter(&ticks);
+        region.calls.fetch_add(1, std::memory_order_relaxed);
+        region.ticks.fetch_add(ticks.QuadPart - startTicks, std::memory_order_relaxed);
+        region.cycles.fetch_add(cycles - startCycles, std::memory_order_relaxed);
+    }
+
+    void enableRegions(bool enable) {
+        regionsEnabled = enable;
+    }
+
+    std::vector<region_stats_t> takeRegionStats() {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        std::vector<region_stats_t> stats;
+        std::lock_guard lock(regionsMutex);
+        for (Region* region : regionList) {
+            uint64_t calls = region->calls.exchange(0);
+            int64_t ticks = region->ticks.exchange(0);
+            uint64_t cycles = region->cycles.exchange(0);
+            if (calls != 0) {
+                stats.push_back({ region->name, calls, 1000.0 * ticks / frequency.QuadPart, cycles });
             }
         }
+        return stats;
     }
 }
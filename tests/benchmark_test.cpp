@@ -0,0 +1,162 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file benchmark_test.cpp
+ * @brief Tests the benchmark run sequencer of benchmark.hpp against simulated frames.
+ */
+
+#include <chrono>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "test.hpp"
+
+using Utils::benchmark_action_t;
+using Utils::benchmark_state_t;
+using namespace std::chrono_literals;
+
+/**
+ * @brief Frame events fed to the sequencer, one per simulated frame.
+ */
+typedef struct frame_t {
+    bool ready = false;
+    bool triggered = false;
+    bool regionsReset = false;
+} frame_t;
+
+/**
+ * @brief Runs frames of `interval` through a sequencer and collects what it did.
+ */
+class Simulation {
+public:
+    Simulation(Utils::benchmark_config_t config, std::chrono::milliseconds interval) : sequencer(config), interval(interval) {}
+
+    void run(size_t frames, frame_t events) {
+        for (size_t i = 0; i < frames; i++) {
+            now += interval;
+            auto step = sequencer.step(now, events.ready, events.triggered, events.regionsReset);
+            if (step.action != benchmark_action_t::None) {
+                actions.push_back({ step.action, frame });
+            }
+            recorded += step.record ? 1 : 0;
+            frame++;
+        }
+    }
+
+    typedef struct action_t {
+        benchmark_action_t action;
+        size_t frame;
+    } action_t;
+
+    Utils::BenchmarkSequencer sequencer;
+    std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::time_point{} + 1h;
+    std::vector<action_t> actions;
+    size_t recorded = 0;
+    size_t frame = 0;
+};
+
+/**
+ * @brief A triggered run warms up, waits for the reset, records for its duration and stops.
+ */
+void testTriggeredRun() {
+    Simulation simulation({ 0, 1, 2 }, 10ms);
+    simulation.run(500, { true, false, false });
+    CHECK(simulation.actions.empty());
+    CHECK(simulation.sequencer.current() == benchmark_state_t::Waiting);
+
+    simulation.run(1, { true, true, false });
+    // One second of warmup at 100 fps, then the reset is asked for once
+    simulation.run(150, { true, true, false });
+    simulation.run(10, { true, true, true });
+    simulation.run(300, { true, true, true });
+
+    const auto& actions = simulation.actions;
+    CHECK(actions.size() == 4);
+    CHECK(actions[0].action == benchmark_action_t::Started && actions[0].frame == 500);
+    CHECK(actions[1].action == benchmark_action_t::ResetRegions && actions[1].frame == 600);
+    CHECK(actions[2].action == benchmark_action_t::Recording && actions[2].frame == 651);
+    CHECK(actions[3].action == benchmark_action_t::Finished && actions[3].frame == 851);
+    CHECK(simulation.recorded == 200);
+    CHECK(simulation.sequencer.current() == benchmark_state_t::Done);
+    CHECK(!simulation.sequencer.startedAutomatically());
+}
+
+/**
+ * @brief With a start gate the run starts on its own, counted from when the game was ready.
+ */
+void testAutomaticStart() {
+    Simulation simulation({ 5, 0, 1 }, 100ms);
+    simulation.run(100, { false, false, true });
+    CHECK(simulation.actions.empty());
+
+    simulation.run(100, { true, false, true });
+    CHECK(simulation.actions.size() == 4);
+    CHECK(simulation.actions[0].action == benchmark_action_t::Started && simulation.actions[0].frame == 150);
+    CHECK(simulation.actions[1].action == benchmark_action_t::ResetRegions && simulation.actions[1].frame == 151);
+    CHECK(simulation.actions[2].action == benchmark_action_t::Recording && simulation.actions[2].frame == 152);
+    CHECK(simulation.actions[3].action == benchmark_action_t::Finished && simulation.actions[3].frame == 162);
+    CHECK(simulation.sequencer.startedAutomatically());
+    CHECK(simulation.sequencer.current() == benchmark_state_t::Done);
+    CHECK(simulation.recorded == 10);
+}
+
+/**
+ * @brief Without a start gate only the trigger starts a run, and the trigger wins over the gate.
+ */
+void testManualOnly() {
+    Simulation simulation({ 0, 0, 1 }, 100ms);
+    simulation.run(1000, { true, false, true });
+    CHECK(simulation.actions.empty());
+
+    Simulation both({ 60, 0, 1 }, 100ms);
+    both.run(10, { true, false, true });
+    both.run(1, { true, true, true });
+    CHECK(!both.actions.empty() && both.actions[0].action == benchmark_action_t::Started);
+    CHECK(!both.sequencer.startedAutomatically());
+}
+
+/**
+ * @brief The same frames give the same run.
+ */
+void testDeterministic() {
+    Simulation first({ 1, 1, 1 }, 16ms);
+    Simulation second({ 1, 1, 1 }, 16ms);
+    first.run(400, { true, false, true });
+    second.run(400, { true, false, true });
+    CHECK(first.actions.size() == second.actions.size());
+    for (size_t i = 0; i < first.actions.size() && i < second.actions.size(); i++) {
+        CHECK(first.actions[i].action == second.actions[i].action && first.actions[i].frame == second.actions[i].frame);
+    }
+    CHECK(first.recorded == second.recorded && first.recorded > 0);
+}
+
+int main() {
+    testTriggeredRun();
+    testAutomaticStart();
+    testManualOnly();
+    testDeterministic();
+    return report();
+}
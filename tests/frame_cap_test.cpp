@@ -0,0 +1,92 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file frame_cap_test.cpp
+ * @brief Tests the window classification and frame cap decisions of frame_cap.hpp.
+ */
+
+#include <chrono>
+
+#include "frame_cap.hpp"
+#include "test.hpp"
+
+using Utils::window_state_t;
+using namespace std::chrono_literals;
+
+/**
+ * @brief Minimized beats background beats idle, and idling can be turned off.
+ */
+void testClassify() {
+    CHECK(Utils::classifyWindow(false, true, 0, 60000) == window_state_t::Foreground);
+    CHECK(Utils::classifyWindow(false, true, 59999, 60000) == window_state_t::Foreground);
+    CHECK(Utils::classifyWindow(false, true, 60000, 60000) == window_state_t::Idle);
+    CHECK(Utils::classifyWindow(false, true, 1000000, 0) == window_state_t::Foreground);
+    CHECK(Utils::classifyWindow(false, false, 1000000, 60000) == window_state_t::Background);
+    CHECK(Utils::classifyWindow(true, false, 1000000, 60000) == window_state_t::Minimized);
+    CHECK(Utils::classifyWindow(true, true, 0, 60000) == window_state_t::Minimized);
+}
+
+/**
+ * @brief The delay fills the rest of the capped interval, in microseconds, never less than zero.
+ */
+void testDelay() {
+    auto start = std::chrono::steady_clock::time_point{} + 1h;
+    CHECK(Utils::capDelay(window_state_t::Foreground, 15, start, start) == 0us);
+    CHECK(Utils::capDelay(window_state_t::Background, 15, start, start) == 66666us);
+    CHECK(Utils::capDelay(window_state_t::Idle, 30, start, start + 10ms) == 23333us);
+    CHECK(Utils::capDelay(window_state_t::Minimized, 60, start, start + 20ms) == 0us);
+    // A cap of 0 fps is treated as 1 fps instead of dividing by zero
+    CHECK(Utils::capDelay(window_state_t::Minimized, 0, start, start) == 1s);
+}
+
+/**
+ * @brief Changes are reported once, and the cap is lifted on the frame the window is back.
+ */
+void testTransitions() {
+    Utils::FrameCap cap;
+    auto start = std::chrono::steady_clock::time_point{} + 1h;
+    auto decision = cap.step(false, true, 0, 60000, 15, start, start);
+    CHECK(decision.state == window_state_t::Foreground && !decision.changed && decision.delay == 0us);
+
+    decision = cap.step(false, false, 0, 60000, 15, start, start + 1ms);
+    CHECK(decision.state == window_state_t::Background && decision.changed && decision.delay == 65666us);
+    decision = cap.step(false, false, 0, 60000, 15, start, start + 1ms);
+    CHECK(decision.state == window_state_t::Background && !decision.changed);
+
+    decision = cap.step(false, true, 0, 60000, 15, start, start + 1ms);
+    CHECK(decision.state == window_state_t::Foreground && decision.changed && decision.delay == 0us);
+
+    decision = cap.step(false, true, 60000, 60000, 15, start, start);
+    CHECK(decision.state == window_state_t::Idle && decision.changed && decision.delay == 66666us);
+    decision = cap.step(false, true, 5, 60000, 15, start, start);
+    CHECK(decision.state == window_state_t::Foreground && decision.changed && decision.delay == 0us);
+}
+
+int main() {
+    testClassify();
+    testDelay();
+    testTransitions();
+    return report();
+}
@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file memory_governor_test.cpp
+ * @brief Tests the streaming setting steps and hysteresis of memory_governor.hpp.
+ */
+
+#include <vector>
+
+#include "memory_governor.hpp"
+#include "test.hpp"
+
+using Utils::memory_sample_t;
+using Utils::memory_settings_t;
+
+const memory_sample_t pressure = { 95, false, true };
+const memory_sample_t overBudget = { 50, true, false };
+const memory_sample_t headroom = { 60, false, true };
+const memory_sample_t between = { 80, false, true };
+
+/**
+ * @brief The pool shrinks to its minimum before the mip bias rises, raising undoes it in reverse.
+ */
+void testSteps() {
+    Utils::memory_limits_t limits;
+    memory_settings_t settings = { 2000, 0 };
+    settings = Utils::lowerMemory(settings, limits);
+    CHECK(settings == memory_settings_t({ 1500, 0 }));
+    settings = Utils::lowerMemory(Utils::lowerMemory(settings, limits), limits);
+    CHECK(settings == memory_settings_t({ 1000, 1 }));
+    CHECK(Utils::lowerMemory(settings, limits) == settings);
+
+    settings = Utils::raiseMemory(settings, limits);
+    CHECK(settings == memory_settings_t({ 1000, 0 }));
+    settings = Utils::raiseMemory(settings, limits);
+    CHECK(settings == memory_settings_t({ 1500, 0 }));
+    CHECK(Utils::raiseMemory({ 3800, 0 }, limits) == memory_settings_t({ 4000, 0 }));
+    CHECK(Utils::raiseMemory({ 4000, 0 }, limits) == memory_settings_t({ 4000, 0 }));
+
+    limits.maxMipBias = 0;
+    CHECK(Utils::lowerMemory({ 1000, 0 }, limits) == memory_settings_t({ 1000, 0 }));
+}
+
+/**
+ * @brief Settings only move after `samples` samples in a row on the same side.
+ */
+void testHysteresis() {
+    Utils::MemoryGovernor governor({});
+    memory_settings_t settings = { 2000, 0 };
+    CHECK(governor.step(pressure, settings) == settings);
+    CHECK(governor.step(pressure, settings) == settings);
+    // A sample between the thresholds breaks the streak
+    CHECK(governor.step(between, settings) == settings);
+    CHECK(governor.step(pressure, settings) == settings);
+    CHECK(governor.step(overBudget, settings) == settings);
+    settings = governor.step(pressure, settings);
+    CHECK(settings == memory_settings_t({ 1500, 0 }));
+    // The streak starts over after an adjustment
+    CHECK(governor.step(pressure, settings) == settings);
+
+    CHECK(governor.step(headroom, settings) == settings);
+    CHECK(governor.step(headroom, settings) == settings);
+    CHECK(governor.step(headroom, settings) == memory_settings_t({ 2000, 0 }));
+}
+
+/**
+ * @brief Video memory over budget or without headroom keeps the settings from rising.
+ */
+void testVideoMemory() {
+    Utils::MemoryGovernor governor({});
+    memory_settings_t settings = { 2000, 0 };
+    memory_sample_t full = { 50, false, false };
+    for (int i = 0; i < 10; i++) {
+        CHECK(governor.step(full, settings) == settings);
+    }
+    for (int i = 0; i < 2; i++) {
+        settings = governor.step(overBudget, settings);
+    }
+    CHECK(governor.step(overBudget, settings) == memory_settings_t({ 1500, 0 }));
+}
+
+int main() {
+    testSteps();
+    testHysteresis();
+    testVideoMemory();
+    return report();
+}
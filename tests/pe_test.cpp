@@ -0,0 +1,202 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file pe_test.cpp
+ * @brief Tests the import slot lookup and patch range planning of pe.hpp.
+ *
+ * @details
+ * A minimal PE32+ image is built in memory, with headers, an import descriptor per DLL, a
+ * lookup table and an address table, laid out as the loader maps them.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "pe.hpp"
+#include "test.hpp"
+
+/**
+ * @brief Builds a mapped PE32+ image importing the given functions.
+ *
+ * @details
+ * Each DLL gets a descriptor; its lookup table and address table hold one entry per
+ * function, names as hint/name entries, and an empty name stands for an import by
+ * ordinal. Address table slots are filled with 0x1000 + the slot's index, as if bound.
+ */
+class Image {
+public:
+    typedef struct dll_t {
+        std::string name;
+        std::vector<std::string> functions;
+        bool lookupTable = true;
+    } dll_t;
+
+    explicit Image(std::initializer_list<dll_t> list) : bytes(0x4000, 0) {
+        std::vector<dll_t> dlls(list);
+        const uint32_t nt = 0x80;
+        const uint32_t descriptors = 0x200;
+        uint32_t data = 0x400;
+        write<uint16_t>(0, 0x5A4D);
+        write<int32_t>(0x3C, nt);
+        write<uint32_t>(nt, 0x4550);
+        write<uint16_t>(nt + 24, 0x20B);
+        write<uint32_t>(nt + 24 + 112 + 8, descriptors);
+
+        uint64_t bound = 0x1000;
+        for (size_t d = 0; d < dlls.size(); d++) {
+            const auto& dll = dlls[d];
+            uint32_t descriptor = descriptors + (uint32_t)d * 20;
+            uint32_t name = text(&data, dll.name);
+            uint32_t lookup = data;
+            data += (uint32_t)(dll.functions.size() + 1) * 8;
+            uint32_t address = data;
+            data += (uint32_t)(dll.functions.size() + 1) * 8;
+            for (size_t f = 0; f < dll.functions.size(); f++) {
+                uint64_t entry = 1ull << 63 | (f + 1);
+                if (!dll.functions[f].empty()) {
+                    data += 2;
+                    entry = text(&data, dll.functions[f]) - 2;
+                }
+                // Before binding the address table is a copy of the lookup table
+                write<uint64_t>(lookup + (uint32_t)f * 8, entry);
+                write<uint64_t>(address + (uint32_t)f * 8, dll.lookupTable ? bound++ : entry);
+            }
+            write<uint32_t>(descriptor + 0, dll.lookupTable ? lookup : 0);
+            write<uint32_t>(descriptor + 12, name);
+            write<uint32_t>(descriptor + 16, address);
+        }
+    }
+
+    void* base() { return bytes.data(); }
+
+private:
+    template <typename T>
+    void write(uint32_t rva, T value) {
+        memcpy(bytes.data() + rva, &value, sizeof(value));
+    }
+
+    uint32_t text(uint32_t* data, const std::string& value) {
+        uint32_t rva = *data;
+        memcpy(bytes.data() + rva, value.c_str(), value.size() + 1);
+        *data += (uint32_t)(value.size() + 2) & ~1u;
+        return rva;
+    }
+
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ * @brief Slots are found by DLL and function name, and rewriting one is seen by the image.
+ */
+void testFindsSlot() {
+    Image image({
+        { "KERNEL32.dll", { "CreateFileW", "ReadFile", "WriteFile" } },
+        { "USER32.dll", { "PostQuitMessage" } }
+    });
+    uint64_t* readFile = Utils::findImportSlot(image.base(), "kernel32.dll", "ReadFile");
+    uint64_t* writeFile = Utils::findImportSlot(image.base(), "kernel32.dll", "WriteFile");
+    uint64_t* quit = Utils::findImportSlot(image.base(), "user32.dll", "PostQuitMessage");
+    CHECK(readFile != nullptr && writeFile != nullptr && quit != nullptr);
+    CHECK(writeFile == readFile + 1);
+    CHECK(*readFile == 0x1001);
+    CHECK(*quit == 0x1003);
+
+    *readFile = 0xDE7002;
+    CHECK(*Utils::findImportSlot(image.base(), "KERNEL32.DLL", "ReadFile") == 0xDE7002);
+}
+
+/**
+ * @brief Missing DLLs and functions, wrong case in function names and ordinals are not matched.
+ */
+void testMisses() {
+    Image image({
+        { "KERNEL32.dll", { "CreateFileW", "", "Sleep" } }
+    });
+    CHECK(Utils::findImportSlot(image.base(), "user32.dll", "CreateFileW") == nullptr);
+    CHECK(Utils::findImportSlot(image.base(), "kernel32.dll", "ReadFile") == nullptr);
+    CHECK(Utils::findImportSlot(image.base(), "kernel32.dll", "createfilew") == nullptr);
+    CHECK(Utils::findImportSlot(image.base(), "kernel32", "CreateFileW") == nullptr);
+    // The ordinal import in between does not shift the slots after it
+    uint64_t* sleep = Utils::findImportSlot(image.base(), "kernel32.dll", "Sleep");
+    CHECK(sleep == Utils::findImportSlot(image.base(), "kernel32.dll", "CreateFileW") + 2);
+}
+
+/**
+ * @brief Without a lookup table the names are read from the unbound address table.
+ */
+void testWithoutLookupTable() {
+    Image image({
+        { "dxgi.dll", { "CreateDXGIFactory1" }, false }
+    });
+    CHECK(Utils::findImportSlot(image.base(), "DXGI.dll", "CreateDXGIFactory1") != nullptr);
+}
+
+/**
+ * @brief Images that are not PE32+ or import nothing have no slots.
+ */
+void testRejectsOtherImages() {
+    Image image({
+        { "KERNEL32.dll", { "Sleep" } }
+    });
+    uint8_t* bytes = (uint8_t*)image.base();
+    bytes[0x80 + 24] = 0x0B;
+    bytes[0x80 + 25] = 0x01;
+    CHECK(Utils::findImportSlot(image.base(), "kernel32.dll", "Sleep") == nullptr);
+
+    Image empty{};
+    memset((uint8_t*)empty.base() + 0x80 + 24 + 120, 0, 4);
+    CHECK(Utils::findImportSlot(empty.base(), "kernel32.dll", "Sleep") == nullptr);
+}
+
+/**
+ * @brief Writes in the same or adjacent pages share one range, distant ones do not.
+ */
+void testPageRanges() {
+    const size_t page = 0x1000;
+    auto ranges = Utils::pageRanges({
+        { 0x5010, 8 }, { 0x1FFC, 8 }, { 0x1100, 4 }, { 0x5FF0, 4 }, { 0x9000, 0 }
+    }, page);
+    CHECK(ranges.size() == 2);
+    CHECK(ranges[0].address == 0x1000 && ranges[0].size == 0x2000);
+    CHECK(ranges[1].address == 0x5000 && ranges[1].size == 0x1000);
+
+    ranges = Utils::pageRanges({ { 0x3000, 0x1000 }, { 0x4000, 1 } }, page);
+    CHECK(ranges.size() == 1 && ranges[0].address == 0x3000 && ranges[0].size == 0x2000);
+
+    CHECK(Utils::pageRanges({}, page).empty());
+}
+
+int main() {
+    testFindsSlot();
+    testMisses();
+    testWithoutLookupTable();
+    testRejectsOtherImages();
+    testPageRanges();
+    return report();
+}
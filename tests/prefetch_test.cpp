@@ -0,0 +1,158 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file prefetch_test.cpp
+ * @brief Tests the prefetch planning of prefetch.hpp.
+ *
+ * @details
+ * Traces are written to a plain file and read back, as the prefetcher reads the trace the
+ * file tracer wrote in previous sessions.
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "prefetch.hpp"
+#include "test.hpp"
+
+const uint64_t KB = 1024;
+const uint64_t MB = 1024 * KB;
+
+/**
+ * @brief Writes a trace to a temporary file and opens it for reading.
+ */
+std::ifstream traceFile(const std::string& contents) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "CodeVeinFix.prefetch_test.csv";
+    std::ofstream(path) << contents;
+    return std::ifstream(path);
+}
+
+/**
+ * @brief Nearby reads merge, the header and malformed lines are skipped, commas in names survive.
+ */
+void testParse() {
+    std::ifstream trace = traceFile(
+        "frame,thread,offset,size,ms,name\n"
+        "10,1,0,4096,0.1,C:\\Game\\a.pak\n"
+        "12,1,8192,4096,0.1,C:\\Game\\a.pak\n"
+        "5,1,60000,4096,0.1,C:\\Game\\a.pak\n"
+        "20,1,0,4096,0.1,C:\\Game\\b,c.pak\n"
+        "not,a,read\n"
+        "30,1,x,4096,0.1,C:\\Game\\d.pak\n"
+        "40,1,0,0,0.1,C:\\Game\\empty.pak\n"
+    );
+    Utils::PrefetchPlan plan(trace, 1 * MB);
+    CHECK(plan.size() == 2);
+    auto ranges = plan.startup(1000);
+    CHECK(ranges.size() == 2);
+    // Merged within 64 KB, keeping the earliest frame of the merged reads
+    CHECK(ranges[0].name == "C:\\Game\\a.pak");
+    CHECK(ranges[0].range.offset == 0 && ranges[0].range.size == 64096 && ranges[0].range.frame == 5);
+    CHECK(ranges[1].name == "C:\\Game\\b,c.pak");
+    CHECK(plan.budget() == 1 * MB - 64096 - 4096);
+}
+
+/**
+ * @brief Startup plans in frame order, within its frames, and stops at the budget.
+ */
+void testStartup() {
+    std::istringstream trace(
+        "300,1,0,65536,0.1,early.pak\n"
+        "100,1,0,65536,0.1,first.pak\n"
+        "200,1,0,65536,0.1,second.pak\n"
+        "5000,1,0,65536,0.1,area.pak\n"
+    );
+    Utils::PrefetchPlan plan(trace, 128 * KB);
+    auto ranges = plan.startup(1000);
+    CHECK(ranges.size() == 2);
+    CHECK(ranges[0].name == "first.pak" && ranges[1].name == "second.pak");
+    CHECK(plan.budget() == 0);
+    CHECK(plan.startup(1000).empty());
+
+    std::istringstream again(
+        "100,1,0,65536,0.1,first.pak\n"
+        "5000,1,0,65536,0.1,area.pak\n"
+    );
+    Utils::PrefetchPlan roomy(again, 1 * MB);
+    ranges = roomy.startup(1000);
+    CHECK(ranges.size() == 1 && ranges[0].name == "first.pak");
+}
+
+/**
+ * @brief A read of a traced range plans what followed it, once, and never a range twice.
+ */
+void testFollow() {
+    std::istringstream trace(
+        "100,1,0,65536,0.1,start.pak\n"
+        "5000,1,0,65536,0.1,area.pak\n"
+        "5100,1,1000000,65536,0.1,area.pak\n"
+        "5200,1,0,65536,0.1,textures.pak\n"
+        "9000,1,0,65536,0.1,later.pak\n"
+    );
+    Utils::PrefetchPlan plan(trace, 1 * MB);
+    CHECK(plan.startup(1000).size() == 1);
+
+    // Not traced, or outside every traced range of the file
+    CHECK(plan.follow("unknown.pak", 0, 1000).empty());
+    CHECK(plan.follow("area.pak", 500000, 1000).empty());
+
+    auto ranges = plan.follow("area.pak", 4096, 1000);
+    CHECK(ranges.size() == 2);
+    CHECK(ranges[0].name == "area.pak" && ranges[0].range.offset == 1000000);
+    CHECK(ranges[1].name == "textures.pak");
+
+    // Followed already, and its successors are planned already
+    CHECK(plan.follow("area.pak", 0, 1000).empty());
+    CHECK(plan.follow("area.pak", 1000000, 1000).empty());
+    CHECK(plan.follow("textures.pak", 0, 10000).size() == 1);
+    CHECK(plan.budget() == 1 * MB - 5 * 65536 + 65536);
+}
+
+/**
+ * @brief Following stops once the budget is spent.
+ */
+void testFollowBudget() {
+    std::istringstream trace(
+        "5000,1,0,65536,0.1,area.pak\n"
+        "5100,1,0,65536,0.1,big.pak\n"
+        "5200,1,0,65536,0.1,after.pak\n"
+    );
+    Utils::PrefetchPlan plan(trace, 64 * KB);
+    auto ranges = plan.follow("area.pak", 0, 1000);
+    CHECK(ranges.size() == 1 && ranges[0].name == "big.pak");
+    CHECK(plan.budget() == 0);
+    CHECK(plan.follow("big.pak", 0, 1000).empty());
+}
+
+int main() {
+    testParse();
+    testStartup();
+    testFollow();
+    testFollowBudget();
+    return report();
+}
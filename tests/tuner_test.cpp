@@ -0,0 +1,166 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Dominik Protasewicz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file tuner_test.cpp
+ * @brief Tests the settings search of tuner.hpp against a synthetic cost model.
+ *
+ * @details
+ * Every parameter's lower quality values add a fixed frame rate, so the fastest point is
+ * known, and the same point always scores the same, as a benchmark of settings would on
+ * a quiet machine.
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tuner.hpp"
+#include "test.hpp"
+
+/**
+ * @brief Frame rate gained by each value of each parameter, on top of 60.
+ */
+const std::vector<std::vector<double>> gains = {
+    { 0, 10, 15 },
+    { 0, 6 },
+    { 0, 4, 7, 9 }
+};
+
+double score(const std::vector<int>& point) {
+    double fps = 60.0;
+    for (size_t i = 0; i < point.size(); i++) {
+        fps += gains[i][point[i]];
+    }
+    return fps;
+}
+
+Utils::tuner_space_t space(double qualityFloor) {
+    Utils::tuner_space_t space;
+    space.sizes = { 3, 2, 4 };
+    space.quality = { { 100, 80, 60 }, { 100, 70 }, { 100, 90, 70, 50 } };
+    space.qualityFloor = qualityFloor;
+    return space;
+}
+
+/**
+ * @brief Runs a whole search, one benchmark per point, and returns the points in order.
+ *
+ * @details
+ * Also checks what must hold for every run: no point is scored twice and none is below
+ * the quality floor.
+ */
+std::vector<std::vector<int>> search(Utils::tuner_state_t& state, const Utils::tuner_space_t& space) {
+    std::vector<std::vector<int>> points;
+    std::set<std::vector<int>> seen;
+    if (!Utils::tunerStart(state, space)) {
+        return points;
+    }
+    do {
+        CHECK(seen.insert(state.current).second);
+        CHECK(Utils::tunerQuality(space, state.current) >= space.qualityFloor);
+        points.push_back(state.current);
+    } while (Utils::tunerRecord(state, space, score(state.current)) && points.size() < 100);
+    CHECK(state.done);
+    CHECK(state.current == state.best);
+    return points;
+}
+
+/**
+ * @brief Without a floor the fastest value of every parameter is found in one pass.
+ */
+void testFindsFastest() {
+    Utils::tuner_state_t state;
+    auto points = search(state, space(0));
+    CHECK(state.best == std::vector<int>({ 2, 1, 3 }));
+    // First pass tries 1 + 2 + 1 + 3 points, the second only the values not tried with the new best
+    CHECK(points.size() < 3 * 2 * 4);
+    CHECK(points.front() == std::vector<int>({ 0, 0, 0 }));
+    for (const auto& point : points) {
+        CHECK(state.scores.at(Utils::tunerKey(point)) == score(point));
+    }
+}
+
+/**
+ * @brief Points below the floor are skipped, the best one above it is kept.
+ */
+void testQualityFloor() {
+    Utils::tuner_state_t state;
+    auto points = search(state, space(80));
+    // {2,1,0} and {2,0,2} are faster but both average 76.7
+    CHECK(state.best == std::vector<int>({ 2, 0, 1 }));
+    CHECK(state.scores.at(Utils::tunerKey(state.best)) == 79);
+    CHECK(Utils::tunerQuality(space(80), state.best) >= 80);
+    CHECK(points.size() == 6);
+}
+
+/**
+ * @brief A starting point below the floor is never run.
+ */
+void testStartBelowFloor() {
+    Utils::tuner_space_t below = space(90);
+    below.quality[0][0] = 60;
+    Utils::tuner_state_t state;
+    CHECK(!Utils::tunerStart(state, below));
+    CHECK(state.done);
+    CHECK(search(state, below).empty());
+
+    Utils::tuner_state_t empty;
+    CHECK(!Utils::tunerStart(empty, Utils::tuner_space_t{}));
+}
+
+/**
+ * @brief Missing qualities count as 100.
+ */
+void testMissingQuality() {
+    Utils::tuner_space_t partial = space(0);
+    partial.quality = { { 50 } };
+    CHECK(Utils::tunerQuality(partial, { 0, 0, 0 }) == (50.0 + 100 + 100) / 3);
+    CHECK(Utils::tunerQuality(partial, { 1, 1, 1 }) == 100);
+}
+
+/**
+ * @brief The same scores lead to the same points, and one pass stops after one sweep.
+ */
+void testDeterministic() {
+    Utils::tuner_state_t first;
+    Utils::tuner_state_t second;
+    CHECK(search(first, space(80)) == search(second, space(80)));
+    CHECK(first.scores == second.scores);
+
+    Utils::tuner_space_t single = space(0);
+    single.passes = 1;
+    Utils::tuner_state_t state;
+    CHECK(search(state, single).size() == 1 + 2 + 1 + 3);
+    CHECK(state.best == std::vector<int>({ 2, 1, 3 }));
+}
+
+int main() {
+    testFindsFastest();
+    testQualityFloor();
+    testStartBelowFloor();
+    testMissingQuality();
+    testDeterministic();
+    return report();
+}